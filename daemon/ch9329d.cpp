@@ -0,0 +1,108 @@
+#include <ch9329/Gateway.hpp>
+#include <iostream>
+#include <thread>
+
+namespace {
+    void usage() {
+        std::cerr << "Usage: ch9329d [--tcp HOST:PORT] [--unix PATH] [--shm NAME[:DEVICE]] [--batch N] [--threads N]\n"
+                << "               DEVICE[@BAUD]...\n"
+                << "Serves one or more CH9329 controllers to many clients over TCP and Unix domain sockets.\n";
+    }
+
+    std::pair<std::string, unsigned int> parse_device(const std::string &arg) {
+        const auto at = arg.rfind('@');
+        if (at == std::string::npos) return {arg, 9600};
+        return {arg.substr(0, at), static_cast<unsigned int>(std::stoul(arg.substr(at + 1)))};
+    }
+
+    ender::asio::ip::tcp::endpoint parse_tcp(const std::string &arg) {
+        const auto colon = arg.rfind(':');
+        if (colon == std::string::npos) {
+            return {ender::asio::ip::address_v4::loopback(), static_cast<uint16_t>(std::stoul(arg))};
+        }
+        return {
+            ender::asio::ip::make_address(arg.substr(0, colon)),
+            static_cast<uint16_t>(std::stoul(arg.substr(colon + 1)))
+        };
+    }
+}
+
+int main(int argc, char **argv) {
+    std::vector<std::string> tcp_endpoints;
+    std::vector<std::string> unix_paths;
+    std::vector<std::string> devices;
+    std::vector<std::string> rings;
+    ender::Gateway::Options options;
+    unsigned int threads = std::max(1u, std::thread::hardware_concurrency());
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const bool has_value = i + 1 < argc;
+            if (arg == "--tcp" && has_value) {
+                tcp_endpoints.emplace_back(argv[++i]);
+            } else if (arg == "--unix" && has_value) {
+                unix_paths.emplace_back(argv[++i]);
+            } else if (arg == "--shm" && has_value) {
+                rings.emplace_back(argv[++i]);
+            } else if (arg == "--batch" && has_value) {
+                options.max_batch = std::stoul(argv[++i]);
+            } else if (arg == "--threads" && has_value) {
+                threads = static_cast<unsigned int>(std::stoul(argv[++i]));
+            } else if (!arg.empty() && arg[0] != '-') {
+                devices.push_back(arg);
+            } else {
+                usage();
+                return 2;
+            }
+        }
+        if (devices.empty() || (tcp_endpoints.empty() && unix_paths.empty() && rings.empty())) {
+            usage();
+            return 2;
+        }
+
+        ender::asio::io_context io;
+        ender::Gateway gateway(io, options);
+        for (const auto &device: devices) {
+            const auto [port, baud] = parse_device(device);
+            const auto index = gateway.add_device(port, baud);
+            std::cout << "device " << static_cast<int>(index) << ": " << port << " @ " << baud << std::endl;
+        }
+        for (const auto &endpoint: tcp_endpoints) {
+            const auto port = gateway.listen_tcp(parse_tcp(endpoint));
+            std::cout << "listening on tcp port " << port << std::endl;
+        }
+        for (const auto &path: unix_paths) {
+            gateway.listen_unix(path);
+            std::cout << "listening on " << path << std::endl;
+        }
+
+        for (const auto &ring: rings) {
+            const auto colon = ring.rfind(':');
+            const auto name = ring.substr(0, colon);
+            const auto device = colon == std::string::npos ? 0 : std::stoul(ring.substr(colon + 1));
+            gateway.attach_ring(name, static_cast<uint8_t>(device));
+            std::cout << "input ring " << name << " -> device " << device << std::endl;
+        }
+
+        ender::asio::signal_set signals(io, SIGINT, SIGTERM);
+        signals.async_wait([&](const boost::system::error_code &, int) {
+            gateway.stop();
+            io.stop();
+        });
+
+        std::vector<std::thread> pool;
+        for (unsigned int i = 1; i < threads; ++i) pool.emplace_back([&io] { io.run(); });
+        io.run();
+        for (auto &t: pool) t.join();
+
+        const auto stats = gateway.stats();
+        std::cout << "served " << stats.requests << " requests in " << stats.batches << " batches, "
+                << stats.failures << " failed, " << stats.connections << " connections, "
+                << stats.ring_records << " ring records" << std::endl;
+    } catch (const std::exception &e) {
+        std::cerr << "ch9329d: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include <ch9329/BatchConvert.hpp>
+#include <ch9329/CH9329Controller.hpp>
+#include <iostream>
+#include <random>
+
+// Points per second for converting a long recorded path: per-point convert_screen_to_absolute()
+// against the batch kernels, which are also checked to agree with the scalar mapping.
+int main(int argc, char **argv) {
+    const size_t count = argc > 1 ? std::stoul(argv[1]) : 1 << 20;
+    const int rounds = argc > 2 ? std::stoi(argv[2]) : 20;
+
+    // A random walk over a 3840x2160 screen, straying slightly off-screen now and then
+    std::vector<ender::Point> path(count);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> step(-12, 12);
+    ender::Point p{1920, 1080};
+    for (auto &point: path) {
+        p.x = std::clamp(p.x + step(rng), -50, 3890);
+        p.y = std::clamp(p.y + step(rng), -50, 2210);
+        point = p;
+    }
+    const ender::CoordinateMapper mapper(3840, 2160);
+
+    auto rate = [&](auto &&body) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; ++r) body();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return static_cast<double>(count) * rounds / elapsed.count();
+    };
+
+    std::vector<ender::AbsolutePoint> reference(count);
+    uint64_t sink = 0;
+    const double per_call = rate([&] {
+        for (size_t i = 0; i < count; ++i) {
+            const auto [x, y] = ender::CH9329Controller::convert_screen_to_absolute(
+                static_cast<uint16_t>(std::max(path[i].x, 0)), static_cast<uint16_t>(std::max(path[i].y, 0)),
+                3840, 2160);
+            sink += x + y;
+        }
+    });
+    std::cout << "convert_screen_to_absolute  " << per_call / 1e6 << " M points/s" << std::endl;
+
+    ender::map_points(mapper, path, reference, ender::SimdLevel::Scalar);
+    std::vector<ender::AbsolutePoint> mapped(count);
+    std::vector<uint8_t> frames(count * ender::ABS_FRAME_SIZE);
+    bool all_match = true;
+    for (const auto level: {ender::SimdLevel::Scalar, ender::SimdLevel::SSE2, ender::SimdLevel::AVX2}) {
+        if (level > ender::best_simd_level()) continue;
+        const double map_rate = rate([&] { ender::map_points(mapper, path, mapped, level); });
+        const double encode_rate = rate([&] { ender::encode_abs_frames(mapper, path, frames, 0, 0, level); });
+
+        bool match = true;
+        for (size_t i = 0; i < count && match; ++i) {
+            match = mapped[i].x == reference[i].x && mapped[i].y == reference[i].y;
+            const auto frame = std::span<const uint8_t>(frames).subspan(i * ender::ABS_FRAME_SIZE,
+                                                                        ender::ABS_FRAME_SIZE);
+            const auto expected = ender::protocol::encode<ender::protocol::Command::SendMsAbsData>(
+                ender::protocol::ms_abs_payload(0, reference[i].x, reference[i].y, 0));
+            match = match && std::equal(frame.begin(), frame.end(), expected.begin());
+        }
+        all_match = all_match && match;
+        std::cout << "batch " << ender::to_string(level) << ": map " << map_rate / 1e6 << " M points/s, map+encode "
+                  << encode_rate / 1e6 << " M frames/s" << (match ? "" : "  MISMATCH") << std::endl;
+    }
+    return all_match && sink != 0 ? 0 : 1;
+}
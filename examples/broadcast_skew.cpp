@@ -0,0 +1,54 @@
+#include <ch9329/BroadcastGroup.hpp>
+#include "DeviceSimulator.hpp"
+#include <iostream>
+
+// Skew of one report sent to many simulated devices: a sequential loop over the controllers
+// against a broadcast group writing every port at a common deadline.
+int main(int argc, char **argv) {
+    const size_t devices = argc > 1 ? std::stoul(argv[1]) : 48;
+    const size_t rounds = argc > 2 ? std::stoul(argv[2]) : 20;
+    const unsigned int baud_rate = 9600;
+
+    std::vector<std::unique_ptr<ender::DeviceSimulator> > simulators;
+    std::vector<std::unique_ptr<ender::CH9329Controller> > controllers;
+    ender::BroadcastGroup group;
+    for (size_t d = 0; d < devices; ++d) {
+        simulators.push_back(std::make_unique<ender::DeviceSimulator>());
+        simulators.back()->set_line_rate(baud_rate);
+        controllers.push_back(std::make_unique<ender::CH9329Controller>(simulators.back()->port_path(), baud_rate));
+        group.add(*controllers.back());
+    }
+
+    constexpr auto frame = ender::protocol::encode<ender::protocol::Command::SendMsRelData>(
+        ender::protocol::ms_rel_payload(0x00, 1, -1, 0));
+
+    double sequential_us = 0;
+    for (size_t r = 0; r < rounds; ++r) {
+        const auto first = std::chrono::steady_clock::now();
+        auto last = first;
+        for (const auto &controller: controllers) {
+            controller->send_ms_rel_data(ender::MouseButton::None, 1, -1);
+            last = std::chrono::steady_clock::now();
+        }
+        sequential_us = std::max(sequential_us, std::chrono::duration<double, std::micro>(last - first).count());
+    }
+
+    double broadcast_us = 0;
+    double worst_offset_us = 0;
+    size_t failures = 0;
+    for (size_t r = 0; r < rounds; ++r) {
+        const auto report = group.broadcast(frame);
+        broadcast_us = std::max(broadcast_us, std::chrono::duration<double, std::micro>(report.max_skew()).count());
+        for (const auto &device: report.devices) {
+            worst_offset_us = std::max(worst_offset_us,
+                                       std::chrono::duration<double, std::micro>(device.offset).count());
+        }
+        failures += report.failures();
+    }
+
+    std::cout << devices << " devices at " << baud_rate << " baud, worst of " << rounds << " rounds" << std::endl;
+    std::cout << "  sequential loop skew:  " << sequential_us << " us" << std::endl;
+    std::cout << "  broadcast group skew:  " << broadcast_us << " us (latest write "
+              << worst_offset_us << " us after deadline, " << failures << " failures)" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
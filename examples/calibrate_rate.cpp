@@ -0,0 +1,67 @@
+#include "DeviceSimulator.hpp"
+#include <ch9329/RateCalibration.hpp>
+#include <iostream>
+#include <thread>
+
+// Calibrate the keystroke rate of a host and store it. Usage: calibrate_rate DEVICE[@BAUD] HOST_ID
+// or calibrate_rate --simulate, which calibrates against a simulated host absorbing 60 keys/s.
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " DEVICE[@BAUD] HOST_ID | --simulate" << std::endl;
+        return 2;
+    }
+
+    std::unique_ptr<ender::DeviceSimulator> simulator;
+    std::string port = argv[1];
+    std::string host_id = argc > 2 ? argv[2] : "simulated-host";
+    unsigned int baud_rate = 115200;
+    std::unique_ptr<ender::HostRateStore> store;
+    if (port == "--simulate") {
+        simulator = std::make_unique<ender::DeviceSimulator>();
+        simulator->set_line_rate(baud_rate);
+        simulator->set_host_latency(std::chrono::milliseconds(5));
+        simulator->set_host_key_rate(60);
+        port = simulator->port_path();
+        store = std::make_unique<ender::HostRateStore>("/tmp/ch9329-host-rates");
+    } else {
+        if (const auto at = port.find('@'); at != std::string::npos) {
+            baud_rate = std::stoul(port.substr(at + 1));
+            port.resize(at);
+        }
+        store = std::make_unique<ender::HostRateStore>();
+    }
+
+    ender::CH9329Controller controller(port, baud_rate);
+    ender::RateCalibrationOptions options;
+    if (simulator) options.start_rate = 30;
+    const auto result = ender::calibrate_key_rate(controller, options);
+    for (const auto &trial: result.trials) {
+        std::cout << "  " << trial.rate << " keys/s: " << (trial.passed ? "ok" : "dropped") << std::endl;
+    }
+    if (!result.ok()) {
+        std::cerr << "no rate verified (does the host echo lock keys?)" << std::endl;
+        return 1;
+    }
+    std::cout << "verified " << result.verified_rate << " keys/s, using " << result.safe_rate << std::endl;
+    store->save(host_id, result.safe_rate);
+    std::cout << "saved to " << store->path() << std::endl;
+
+    if (simulator) {
+        // A fresh controller picks the rate up from the store
+        ender::CH9329Controller typist(port, baud_rate);
+        const std::vector<uint8_t> keys(200, 0x04); // 'a'
+        for (const bool paced: {false, true}) {
+            typist.set_keystroke_rate(0);
+            if (paced) store->apply(typist, host_id);
+            const auto dropped = simulator->stats().host_dropped;
+            const auto start = std::chrono::steady_clock::now();
+            typist.type_keys(keys);
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            std::cout << (paced ? "  stored rate: " : "  unpaced:     ") << keys.size() << " keys in "
+                      << elapsed.count() << " s, " << simulator->stats().host_dropped - dropped << " lost"
+                      << std::endl;
+        }
+    }
+    return 0;
+}
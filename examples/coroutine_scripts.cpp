@@ -0,0 +1,55 @@
+#include <ch9329/CH9329Controller.hpp>
+#include "DeviceSimulator.hpp"
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <iostream>
+
+// Many click/drag scripts across several simulated devices, all on one thread: waits are timers,
+// and each controller serialises the commands of the scripts that share it.
+namespace {
+    ender::task<void> script(ender::CH9329Controller &ctrl, size_t id, size_t rounds, size_t &ok, size_t &failed) {
+        for (size_t r = 0; r < rounds; ++r) {
+            const auto x = static_cast<uint16_t>((id * 37 + r * 101) % 4096);
+            const auto y = static_cast<uint16_t>((id * 53 + r * 71) % 4096);
+            bool done;
+            if (r % 2 == 0) {
+                done = co_await ctrl.co_click_at_absolute(x, y, ender::MouseButton::Left, 20);
+            } else {
+                done = co_await ctrl.co_drag_absolute(x, y, 4095 - x, 4095 - y);
+            }
+            if (done) ++ok; else ++failed;
+            co_await ctrl.delay(std::chrono::milliseconds(10 + id % 40));
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    const size_t scripts = argc > 1 ? std::stoul(argv[1]) : 2000;
+    const size_t devices = argc > 2 ? std::stoul(argv[2]) : 8;
+    const size_t rounds = argc > 3 ? std::stoul(argv[3]) : 4;
+
+    ender::asio::io_context io;
+    std::vector<std::unique_ptr<ender::DeviceSimulator> > simulators;
+    std::vector<std::unique_ptr<ender::CH9329Controller> > controllers;
+    for (size_t d = 0; d < devices; ++d) {
+        simulators.push_back(std::make_unique<ender::DeviceSimulator>());
+        controllers.push_back(std::make_unique<ender::CH9329Controller>(io, simulators.back()->port_path(), 115200));
+    }
+
+    size_t ok = 0;
+    size_t failed = 0;
+    for (size_t s = 0; s < scripts; ++s) {
+        ender::asio::co_spawn(io, script(*controllers[s % devices], s, rounds, ok, failed), ender::asio::detached);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    io.run();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    size_t frames = 0;
+    for (const auto &sim: simulators) frames += sim->stats().frames;
+    std::cout << scripts << " scripts on " << devices << " devices, one thread: "
+              << ok << " ok, " << failed << " failed, " << frames << " frames in "
+              << elapsed.count() << " s (" << frames / elapsed.count() << " frames/s)" << std::endl;
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,44 @@
+#include "DeviceSimulator.hpp"
+#include <ch9329/Discovery.hpp>
+#include <fcntl.h>
+#include <iostream>
+#include <unistd.h>
+
+// Without arguments, scan /dev/ttyUSB* and /dev/ttyACM*. With "--simulate N", scan N simulated
+// devices plus a few pseudo-terminals that never answer, and report how long the scan took.
+int main(int argc, char **argv) {
+    ender::DiscoveryOptions options;
+    std::vector<std::unique_ptr<ender::DeviceSimulator> > simulators;
+    std::vector<int> silent_fds;
+
+    if (argc > 2 && std::string(argv[1]) == "--simulate") {
+        const size_t devices = std::stoul(argv[2]);
+        for (size_t d = 0; d < devices; ++d) {
+            simulators.push_back(std::make_unique<ender::DeviceSimulator>());
+            simulators.back()->set_line_rate(9600);
+            simulators.back()->set_usb_string(2, "SIM" + std::to_string(10000 + d));
+            options.ports.push_back(simulators.back()->port_path());
+        }
+        for (size_t s = 0; s < devices / 10; ++s) {
+            const int fd = ::posix_openpt(O_RDWR | O_NOCTTY);
+            if (fd < 0 || ::grantpt(fd) != 0 || ::unlockpt(fd) != 0) break;
+            silent_fds.push_back(fd);
+            options.ports.emplace_back(::ptsname(fd));
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = ender::discover(options);
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    for (const auto &[serial, device]: result.devices) {
+        std::cout << serial << " -> " << device.path << " @" << device.baud_rate
+                  << (device.info.usb_connected ? "" : " (host not connected)") << std::endl;
+    }
+    for (const auto &path: result.duplicates) std::cout << "duplicate serial: " << path << std::endl;
+    std::cout << result.devices.size() << " devices, " << result.silent.size() << " silent ports, "
+              << elapsed.count() << " ms" << std::endl;
+
+    for (const int fd: silent_fds) ::close(fd);
+    return simulators.empty() || result.devices.size() == simulators.size() ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+#include "DeviceSimulator.hpp"
+#include <ch9329/Gateway.hpp>
+#include <iostream>
+#include <thread>
+
+// Loopback check and throughput benchmark: simulated devices behind an in-process gateway,
+// half the clients on TCP and half on a Unix socket, each pipelining relative mouse reports.
+int main(int argc, char **argv) {
+    const size_t clients = argc > 1 ? std::stoul(argv[1]) : 128;
+    const size_t requests = argc > 2 ? std::stoul(argv[2]) : 2000;
+    const size_t devices = argc > 3 ? std::stoul(argv[3]) : 2;
+    const size_t depth = argc > 4 ? std::stoul(argv[4]) : 4;
+    const std::string unix_path = "/tmp/ch9329-gateway-bench.sock";
+
+    std::vector<std::unique_ptr<ender::DeviceSimulator> > simulators;
+    ender::asio::io_context io;
+    ender::Gateway gateway(io);
+    for (size_t d = 0; d < devices; ++d) {
+        simulators.push_back(std::make_unique<ender::DeviceSimulator>());
+        gateway.add_device(simulators.back()->port_path(), 115200);
+    }
+    const uint16_t port = gateway.listen_tcp({ender::asio::ip::address_v4::loopback(), 0});
+    gateway.listen_unix(unix_path);
+
+    auto guard = ender::asio::make_work_guard(io);
+    std::vector<std::thread> reactors;
+    for (unsigned int i = 0; i < std::max(2u, std::thread::hardware_concurrency() / 2); ++i) {
+        reactors.emplace_back([&io] { io.run(); });
+    }
+
+    constexpr auto payload = ender::protocol::ms_rel_payload(0x00, 1, -1, 0);
+    std::atomic<size_t> ok{0};
+    std::atomic<size_t> failed{0};
+    std::vector<double> finish_ms(clients);
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t c = 0; c < clients; ++c) {
+        workers.emplace_back([&, c] {
+            try {
+                auto client = c % 2 == 0
+                                  ? ender::GatewayClient(ender::asio::ip::tcp::endpoint(
+                                      ender::asio::ip::address_v4::loopback(), port))
+                                  : ender::GatewayClient(unix_path);
+                const auto device = static_cast<uint8_t>(c % devices);
+                size_t sent = 0;
+                size_t received = 0;
+                while (received < requests) {
+                    while (sent < requests && sent - received < depth) {
+                        client.send(device, ender::protocol::Command::SendMsRelData, payload);
+                        ++sent;
+                    }
+                    const auto reply = client.receive();
+                    ++received;
+                    if (reply && reply->ok()) ++ok; else ++failed;
+                }
+            } catch (const std::exception &e) {
+                std::cerr << "client " << c << ": " << e.what() << std::endl;
+                failed += requests;
+            }
+            finish_ms[c] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        });
+    }
+    for (auto &w: workers) w.join();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    gateway.stop();
+    guard.reset();
+    io.stop();
+    for (auto &r: reactors) r.join();
+
+    const auto [first, last] = std::ranges::minmax(finish_ms);
+    const auto stats = gateway.stats();
+    std::cout << clients << " clients x " << requests << " requests over " << devices << " devices (depth "
+            << depth << ")\n"
+            << "  ok " << ok << ", failed " << failed << "\n"
+            << "  " << static_cast<size_t>(static_cast<double>(ok) / seconds) << " requests/s aggregate, "
+            << static_cast<double>(stats.requests) / static_cast<double>(std::max<uint64_t>(stats.batches, 1))
+            << " requests per serial write\n"
+            << "  client completion spread " << first << " - " << last << " ms" << std::endl;
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+#include "DeviceSimulator.hpp"
+#include <ch9329/HidBulk.hpp>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+// Custom HID throughput against the simulator (2 ms adapter turnaround): one send_hid_data() call per
+// 64 bytes versus send_hid_bulk() with growing windows, then with packets randomly rejected by the device.
+namespace {
+    // Delivered bytes match the source as a multiset of 64-byte packets (resends arrive out of order)
+    bool same_packets(std::span<const uint8_t> sent, std::span<const uint8_t> delivered) {
+        if (sent.size() != delivered.size()) return false;
+        auto packets = [](std::span<const uint8_t> bytes) {
+            std::vector<std::string> out;
+            for (size_t i = 0; i < bytes.size(); i += ender::protocol::MAX_PAYLOAD) {
+                const auto n = std::min(ender::protocol::MAX_PAYLOAD, bytes.size() - i);
+                out.emplace_back(reinterpret_cast<const char *>(bytes.data() + i), n);
+            }
+            std::ranges::sort(out);
+            return out;
+        };
+        return packets(sent) == packets(delivered);
+    }
+}
+
+int main(int argc, char **argv) {
+    const size_t size = argc > 1 ? std::stoul(argv[1]) : 16384;
+    const unsigned int baud_rate = argc > 2 ? std::stoul(argv[2]) : 115200;
+
+    std::vector<uint8_t> data(size);
+    std::minstd_rand rng(48);
+    for (auto &b: data) b = static_cast<uint8_t>(rng());
+
+    ender::DeviceSimulator simulator;
+    simulator.set_line_rate(baud_rate);
+    simulator.set_turnaround(std::chrono::milliseconds(2));
+    ender::CH9329Controller controller(simulator.port_path(), baud_rate);
+
+    std::cout << std::fixed << std::setprecision(0) << size << " bytes at " << baud_rate << " baud" << std::endl;
+    bool all_ok = true;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t offset = 0; offset < data.size(); offset += ender::protocol::MAX_PAYLOAD) {
+        const auto end = data.begin() + static_cast<std::ptrdiff_t>(std::min(offset + ender::protocol::MAX_PAYLOAD, data.size()));
+        controller.send_hid_data(std::vector<uint8_t>(data.begin() + static_cast<std::ptrdiff_t>(offset), end));
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const bool baseline_ok = simulator.take_host_hid() == data;
+    all_ok = all_ok && baseline_ok;
+    std::cout << "  stop-and-wait       " << std::setw(7) << static_cast<double>(size) / elapsed.count()
+              << " B/s  " << (baseline_ok ? "intact" : "CORRUPT") << std::endl;
+
+    auto run = [&](const char *label, size_t window, double failure_rate) {
+        simulator.set_hid_failure_rate(failure_rate);
+        const auto result = ender::send_hid_bulk(controller, data, {window, 8});
+        const auto delivered = simulator.take_host_hid();
+        // Compare as packets whenever anything was resent
+        const bool intact = result.retransmits == 0 ? delivered == data : same_packets(data, delivered);
+        all_ok = all_ok && result.ok() && intact;
+        std::cout << "  " << std::left << std::setw(20) << label << std::right << std::setw(7)
+                  << result.bytes_per_second() << " B/s  " << (intact ? "intact" : "CORRUPT") << ", "
+                  << result.retransmits << " resent, " << result.failed() << " failed" << std::endl;
+    };
+    run("window 1", 1, 0);
+    run("window 2", 2, 0);
+    run("window 4", 4, 0);
+    run("window 8", 8, 0);
+    run("window 4, 2% reject", 4, 0.02);
+    return all_ok ? 0 : 1;
+}
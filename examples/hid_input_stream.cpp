@@ -0,0 +1,120 @@
+#include "DeviceSimulator.hpp"
+#include <ch9329/HidInput.hpp>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+// Upstream custom HID traffic from the simulated host, read by polling read_hid_data() and by a
+// HidInputStream while mouse commands run alongside. Counts heap allocations on the reading threads
+// once traffic is flowing.
+namespace {
+    std::atomic<uint64_t> counted_allocations{0};
+    thread_local bool count_allocations = false;
+
+    constexpr size_t PACKET_SIZE = 32;
+
+    void send_packets(ender::DeviceSimulator &simulator, uint32_t count) {
+        std::array<uint8_t, PACKET_SIZE> packet{};
+        for (uint32_t seq = 0; seq < count; ++seq) {
+            for (size_t i = 0; i < packet.size(); ++i) packet[i] = static_cast<uint8_t>(seq + i);
+            simulator.send_host_hid(packet);
+            // About 80% of what the 115200 baud line carries, leaving room for the mouse commands
+            std::this_thread::sleep_for(std::chrono::milliseconds(4));
+        }
+    }
+
+    bool intact(std::span<const uint8_t> packet) {
+        if (packet.size() != PACKET_SIZE) return false;
+        for (size_t i = 1; i < packet.size(); ++i) {
+            if (packet[i] != static_cast<uint8_t>(packet[0] + i)) return false;
+        }
+        return true;
+    }
+
+    struct Run {
+        uint32_t received = 0;
+        uint32_t corrupt = 0;
+        uint64_t allocations = 0;
+        double seconds = 0;
+    };
+
+    Run poll(ender::DeviceSimulator &simulator, ender::CH9329Controller &controller, uint32_t count) {
+        Run run;
+        counted_allocations = 0;
+        const auto start = std::chrono::steady_clock::now();
+        std::thread host(send_packets, std::ref(simulator), count);
+        count_allocations = true;
+        while (run.received < count) {
+            const auto frame = controller.read_hid_data();
+            if (!frame) break;
+            const auto payload = ender::protocol::decode<ender::protocol::Command::ReadMyHidData>(*frame);
+            ++run.received;
+            if (!payload || !intact(*payload)) ++run.corrupt;
+        }
+        count_allocations = false;
+        host.join();
+        run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        run.allocations = counted_allocations;
+        return run;
+    }
+
+    Run stream(ender::DeviceSimulator &simulator, ender::CH9329Controller &controller, uint32_t count) {
+        Run run;
+        std::atomic<uint32_t> received{0};
+        std::atomic<uint32_t> corrupt{0};
+        ender::HidInputStream input(controller, [&](ender::HidBufferPool::Buffer packet) {
+            count_allocations = true; // Reader and command threads, from the first packet on
+            if (!intact(packet.data())) corrupt.fetch_add(1);
+            packet.release();
+            received.fetch_add(1);
+        });
+        input.start();
+
+        counted_allocations = 0;
+        const auto start = std::chrono::steady_clock::now();
+        std::thread host(send_packets, std::ref(simulator), count);
+        // Commands keep the port busy; packets arriving meanwhile are picked up between responses
+        count_allocations = true;
+        for (int i = 0; received.load() + input.stats().dropped < count; ++i) {
+            if (!controller.send_ms_rel_data(ender::MouseButton::None, i % 2 ? 1 : -1, 0)) break;
+        }
+        count_allocations = false;
+        host.join();
+        run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        input.stop();
+        run.allocations = counted_allocations;
+        run.received = received;
+        run.corrupt = corrupt;
+        return run;
+    }
+
+    void report(const char *name, const Run &run) {
+        std::cout << name << run.received << " packets, " << run.corrupt << " corrupt, " << run.allocations
+                  << " allocations, " << static_cast<double>(run.received) / run.seconds << " packets/s" << std::endl;
+    }
+}
+
+void *operator new(std::size_t size) {
+    if (count_allocations) counted_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+int main(int argc, char **argv) {
+    const uint32_t count = argc > 1 ? static_cast<uint32_t>(std::stoul(argv[1])) : 500;
+
+    ender::DeviceSimulator simulator;
+    simulator.set_line_rate(115200);
+    ender::CH9329Controller controller(simulator.port_path(), 115200);
+
+    const auto polled = poll(simulator, controller, count);
+    report("read_hid_data(): ", polled);
+    const auto streamed = stream(simulator, controller, count);
+    report("HidInputStream:  ", streamed);
+
+    return polled.received == count && streamed.received == count && streamed.corrupt == 0 ? 0 : 1;
+}
@@ -0,0 +1,49 @@
+#include "DeviceSimulator.hpp"
+#include <ch9329/LatencyProbe.hpp>
+#include <iomanip>
+#include <iostream>
+
+// Host input latency via Num Lock echo. Usage: host_latency DEVICE[@BAUD] [SAMPLES]
+// or host_latency --simulate [SAMPLES] for a simulated host answering in 8-12 ms.
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::cerr << "usage: " << argv[0] << " DEVICE[@BAUD] | --simulate [SAMPLES]" << std::endl;
+        return 2;
+    }
+    const size_t samples = argc > 2 ? std::stoul(argv[2]) : 200;
+
+    std::unique_ptr<ender::DeviceSimulator> simulator;
+    std::string port = argv[1];
+    unsigned int baud_rate = 115200;
+    if (port == "--simulate") {
+        simulator = std::make_unique<ender::DeviceSimulator>();
+        simulator->set_line_rate(baud_rate);
+        simulator->set_host_latency(std::chrono::milliseconds(8), std::chrono::milliseconds(4));
+        port = simulator->port_path();
+    } else if (const auto at = port.find('@'); at != std::string::npos) {
+        baud_rate = std::stoul(port.substr(at + 1));
+        port.resize(at);
+    }
+
+    ender::CH9329Controller controller(port, baud_rate);
+    ender::LatencyProbe probe(controller);
+    const auto stats = probe.run(samples);
+
+    auto ms = [](std::chrono::microseconds us) { return static_cast<double>(us.count()) / 1000.0; };
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << stats.samples.size() << " samples, " << stats.lost << " lost, resolution "
+              << ms(stats.resolution()) << " ms" << std::endl;
+    std::cout << "  min " << ms(stats.percentile(0)) << "  p50 " << ms(stats.percentile(50))
+              << "  p90 " << ms(stats.percentile(90)) << "  p99 " << ms(stats.percentile(99))
+              << "  max " << ms(stats.percentile(100)) << "  mean " << ms(stats.mean()) << " ms" << std::endl;
+
+    const auto width = std::chrono::milliseconds(1);
+    const auto buckets = stats.histogram(width);
+    const size_t peak = buckets.empty() ? 1 : *std::max_element(buckets.begin(), buckets.end());
+    for (size_t b = 0; b < buckets.size(); ++b) {
+        if (buckets[b] == 0) continue;
+        std::cout << std::setw(5) << b << "-" << std::setw(3) << b + 1 << " ms |"
+                  << std::string(buckets[b] * 50 / peak, '#') << " " << buckets[b] << std::endl;
+    }
+    return stats.lost == 0 ? 0 : 1;
+}
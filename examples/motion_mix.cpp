@@ -0,0 +1,112 @@
+#include "DeviceSimulator.hpp"
+#include <ch9329/MotionPlanner.hpp>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+// Mixed pointer workload (mostly jitter, some short hops, a few long jumps) sent to a simulated host
+// three ways: absolute reports only, relative reports only, and through the hybrid MotionPlanner.
+namespace {
+    struct Outcome {
+        size_t frames = 0;
+        size_t bytes = 0;
+        size_t misses = 0; // Moves that left the host cursor off the target pixel
+        double seconds = 0;
+    };
+
+    std::vector<ender::Point> workload(uint32_t width, uint32_t height, size_t moves) {
+        std::minstd_rand rng(46);
+        std::vector<ender::Point> targets;
+        ender::Point p{static_cast<int32_t>(width / 2), static_cast<int32_t>(height / 2)};
+        for (size_t i = 0; i < moves; ++i) {
+            const auto kind = rng() % 10;
+            const int range = kind < 7 ? 3 : kind < 9 ? 60 : 0;
+            if (range == 0) {
+                p = {static_cast<int32_t>(rng() % width), static_cast<int32_t>(rng() % height)};
+            } else {
+                p.x = std::clamp<int32_t>(p.x + static_cast<int>(rng() % (2 * range + 1)) - range, 0, width - 1);
+                p.y = std::clamp<int32_t>(p.y + static_cast<int>(rng() % (2 * range + 1)) - range, 0, height - 1);
+            }
+            targets.push_back(p);
+        }
+        return targets;
+    }
+
+    template<typename Move>
+    Outcome run(ender::DeviceSimulator &simulator, const std::vector<ender::Point> &targets, Move move) {
+        Outcome outcome;
+        const auto before = simulator.stats();
+        const auto start = std::chrono::steady_clock::now();
+        for (const auto &target: targets) {
+            outcome.frames += move(target);
+            const auto at = simulator.host_cursor();
+            if (at.x != target.x || at.y != target.y) ++outcome.misses;
+        }
+        outcome.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const auto after = simulator.stats();
+        outcome.bytes = after.bytes_in + after.bytes_out - before.bytes_in - before.bytes_out;
+        return outcome;
+    }
+
+    void compare(const char *name, uint32_t width, uint32_t height, std::span<const ender::Monitor> monitors) {
+        ender::DeviceSimulator simulator;
+        simulator.set_line_rate(115200);
+        simulator.set_host_pointer(width, height);
+        ender::CH9329Controller controller(simulator.port_path(), 115200);
+        const ender::CoordinateMapper mapper(monitors);
+        const auto targets = workload(width, height, 1000);
+
+        auto send = [&controller](const std::vector<uint8_t> &batch, size_t frames) {
+            if (frames > 0) controller.send_frames(batch, frames, [](size_t, std::span<const uint8_t>) {});
+            return frames;
+        };
+
+        const auto absolute = run(simulator, targets, [&](ender::Point target) {
+            const auto a = mapper.map(target);
+            return controller.move_to_absolute(a.x, a.y) ? size_t{1} : size_t{0};
+        });
+
+        // Relative only: one absolute placement, then 1:1 reports of at most 127 counts
+        const ender::AccelerationModel unaccelerated;
+        controller.move_to_absolute(2048, 2048);
+        ender::Point believed = simulator.host_cursor();
+        std::vector<uint8_t> batch;
+        const auto relative = run(simulator, targets, [&](ender::Point target) {
+            batch.clear();
+            const auto reports = unaccelerated.plan(target.x - believed.x, target.y - believed.y);
+            for (const auto &[x, y]: reports) {
+                const auto frame = ender::protocol::encode<ender::protocol::Command::SendMsRelData>(
+                    ender::protocol::ms_rel_payload(0, x, y, 0));
+                batch.insert(batch.end(), frame.begin(), frame.end());
+            }
+            believed = target;
+            return send(batch, reports.size());
+        });
+
+        ender::MotionPlanner planner(mapper);
+        const auto hybrid = run(simulator, targets, [&](ender::Point target) {
+            batch.clear();
+            return send(batch, planner.plan(target, 0, batch));
+        });
+
+        std::cout << name << " (" << width << "x" << height << ", " << targets.size() << " moves)" << std::endl;
+        std::cout << std::fixed << std::setprecision(2);
+        auto row = [](const char *label, const Outcome &o) {
+            std::cout << "  " << std::left << std::setw(10) << label << std::right << std::setw(7) << o.frames
+                      << " frames " << std::setw(8) << o.bytes << " bytes " << std::setw(6) << o.misses
+                      << " misses " << std::setw(7) << o.seconds << " s" << std::endl;
+        };
+        row("absolute", absolute);
+        row("relative", relative);
+        row("hybrid", hybrid);
+    }
+}
+
+int main() {
+    const std::array<ender::Monitor, 1> single{{{0, 0, 1920, 1080, 1.0}}};
+    compare("single screen", 1920, 1080, single);
+    const std::array<ender::Monitor, 3> wall{{{0, 0, 2560, 1440, 1.0}, {2560, 0, 2560, 1440, 1.0},
+                                              {5120, 0, 2560, 1440, 1.0}}};
+    compare("three screens", 7680, 1440, wall);
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include "DeviceSimulator.hpp"
+#include <ch9329/PointerAcceleration.hpp>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+// Calibrates the host pointer curve of a simulated 1920x1080 host with acceleration enabled, then
+// compares relative moves planned 1:1 against moves planned through the calibrated model.
+int main() {
+    ender::DeviceSimulator simulator;
+    simulator.set_line_rate(115200);
+    // Speed-dependent gain: 0.6x for slow reports rising to 2.4x from 40 counts per report
+    simulator.set_host_pointer(1920, 1080, [](int counts) {
+        return counts * (0.6 + 1.8 * std::min(counts, 40) / 40.0);
+    });
+
+    ender::CH9329Controller controller(simulator.port_path(), 115200);
+    const ender::CursorObserver observer = [&simulator] { return std::optional(simulator.host_cursor()); };
+
+    ender::AccelerationCalibrationOptions options;
+    options.settle = std::chrono::milliseconds(5);
+    const auto model = ender::calibrate_acceleration(controller, observer, options);
+    if (!model) {
+        std::cerr << "calibration failed" << std::endl;
+        return 1;
+    }
+    std::cout << "model: " << model->to_string() << std::endl;
+
+    const ender::AccelerationModel unaccelerated;
+    const std::array<std::pair<int, int>, 6> moves = {{{5, 3}, {40, -25}, {150, 90}, {-333, 201}, {700, -410}, {-850, -470}}};
+    int naive_error = 0;
+    int compensated_error = 0;
+    std::cout << std::setw(14) << "move" << std::setw(20) << "1:1 landed" << std::setw(24) << "compensated landed"
+              << std::setw(10) << "reports" << std::endl;
+    for (const auto &[dx, dy]: moves) {
+        auto landed = [&](const ender::AccelerationModel &m) {
+            controller.move_to_absolute(2048, 2048);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            const auto start = simulator.host_cursor();
+            move_compensated(controller, m, dx, dy);
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            const auto end = simulator.host_cursor();
+            return std::pair{end.x - start.x, end.y - start.y};
+        };
+        const auto naive = landed(unaccelerated);
+        const auto compensated = landed(*model);
+        naive_error += std::abs(naive.first - dx) + std::abs(naive.second - dy);
+        compensated_error += std::abs(compensated.first - dx) + std::abs(compensated.second - dy);
+
+        auto text = [](int x, int y) { return "(" + std::to_string(x) + "," + std::to_string(y) + ")"; };
+        std::cout << std::setw(14) << text(dx, dy) << std::setw(20) << text(naive.first, naive.second)
+                  << std::setw(24) << text(compensated.first, compensated.second)
+                  << std::setw(10) << model->plan(dx, dy).size() << std::endl;
+    }
+    std::cout << "total error: 1:1 " << naive_error << " px, compensated " << compensated_error << " px" << std::endl;
+    return compensated_error <= static_cast<int>(moves.size()) * 3 ? 0 : 1;
+}
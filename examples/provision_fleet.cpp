@@ -0,0 +1,55 @@
+#include "DeviceSimulator.hpp"
+#include <ch9329/Provisioning.hpp>
+#include <iostream>
+
+// Provision a rack of simulated devices from a profile blob twice: the first pass writes every
+// device, the second finds them all matching and writes nothing.
+int main(int argc, char **argv) {
+    const size_t devices = argc > 1 ? std::stoul(argv[1]) : 64;
+    const unsigned int baud_rate = 9600;
+
+    std::vector<std::unique_ptr<ender::DeviceSimulator> > simulators;
+    std::vector<ender::ProvisionTarget> targets;
+    for (size_t d = 0; d < devices; ++d) {
+        simulators.push_back(std::make_unique<ender::DeviceSimulator>());
+        simulators.back()->set_line_rate(baud_rate);
+        targets.push_back({simulators.back()->port_path(), baud_rate});
+    }
+
+    ender::DeviceProfile source;
+    source.config.raw_bytes[5] = 0x25; // 9600 baud, big-endian
+    source.config.raw_bytes[6] = 0x80;
+    source.manufacturer = "Test Lab";
+    source.product = "Rack KVM";
+    source.serial_template = "RACK1-####";
+    source.serial_base = 1;
+    const auto profile = ender::DeviceProfile::parse(source.serialize());
+    if (!profile) {
+        std::cerr << "profile blob did not round-trip" << std::endl;
+        return 1;
+    }
+
+    ender::ProvisionOptions options;
+    options.reset_settle = std::chrono::milliseconds(50);
+    bool all_ok = true;
+    for (const char *pass: {"first", "second"}) {
+        const auto start = std::chrono::steady_clock::now();
+        const auto results = ender::provision(*profile, targets, options);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::array<size_t, 6> outcomes{};
+        for (const auto &result: results) {
+            ++outcomes[static_cast<size_t>(result.outcome)];
+            all_ok = all_ok && result.ok();
+        }
+        std::cout << pass << " pass: " << devices << " devices in " << elapsed.count() << " s" << std::endl;
+        for (size_t o = 0; o < outcomes.size(); ++o) {
+            if (outcomes[o] == 0) continue;
+            std::cout << "  " << ender::to_string(static_cast<ender::ProvisionOutcome>(o)) << ": " << outcomes[o]
+                      << std::endl;
+        }
+        std::cout << "  " << results.front().port << " -> " << results.front().serial << ", "
+                  << results.back().port << " -> " << results.back().serial << std::endl;
+    }
+    return all_ok ? 0 : 1;
+}
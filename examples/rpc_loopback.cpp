@@ -0,0 +1,108 @@
+#include "DeviceSimulator.hpp"
+#include <ch9329/HidRpc.hpp>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+
+// RPC calls from the controller side to a companion agent on the simulated host, over custom HID.
+// Compares one call at a time with several in flight, for small and fragmented messages.
+namespace {
+    constexpr uint8_t METHOD_ECHO = 0x01;
+    constexpr uint8_t METHOD_SUM = 0x02;
+
+    struct Run {
+        size_t calls = 0;
+        size_t failures = 0;
+        double seconds = 0;
+    };
+
+    Run bench(ender::HidRpcEndpoint &client, size_t calls, size_t depth, size_t size) {
+        std::vector<uint8_t> request(size);
+        std::iota(request.begin(), request.end(), uint8_t{0});
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t issued = 0;
+        size_t finished = 0;
+        size_t failures = 0;
+
+        // Each completion issues the next call, keeping depth calls in flight. It signals the waiting
+        // thread last, under the lock, so nothing here is touched once bench() may have returned.
+        std::function<void()> issue = [&] {
+            client.call(METHOD_ECHO, request, [&](std::optional<std::vector<uint8_t> > response) {
+                bool next;
+                {
+                    std::lock_guard lock(mutex);
+                    if (!response || *response != request) ++failures;
+                    next = issued < calls;
+                    if (next) ++issued;
+                }
+                if (next) issue();
+                std::lock_guard lock(mutex);
+                ++finished;
+                cv.notify_one();
+            });
+        };
+
+        const auto start = std::chrono::steady_clock::now();
+        const size_t initial = std::min(depth, calls);
+        {
+            std::lock_guard lock(mutex);
+            issued = initial;
+        }
+        for (size_t i = 0; i < initial; ++i) issue();
+        std::unique_lock lock(mutex);
+        cv.wait(lock, [&] { return finished == calls; });
+        return {calls, failures, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()};
+    }
+}
+
+int main(int argc, char **argv) {
+    const size_t calls = argc > 1 ? std::stoul(argv[1]) : 200;
+
+    ender::DeviceSimulator simulator;
+    simulator.set_line_rate(115200);
+    simulator.set_turnaround(std::chrono::milliseconds(2));
+
+    // Host side: the companion agent, fed by the simulated host's custom HID endpoint
+    ender::HidRpcEndpoint agent([&simulator](std::span<const uint8_t> packet) {
+        simulator.send_host_hid(packet);
+        return true;
+    });
+    agent.bind(METHOD_ECHO, [](std::span<const uint8_t> request) {
+        return std::optional(std::vector<uint8_t>(request.begin(), request.end()));
+    });
+    agent.bind(METHOD_SUM, [](std::span<const uint8_t> request) {
+        const uint32_t sum = std::accumulate(request.begin(), request.end(), 0u);
+        return std::optional(std::vector<uint8_t>{static_cast<uint8_t>(sum), static_cast<uint8_t>(sum >> 8)});
+    });
+    simulator.set_host_hid_handler([&agent](std::span<const uint8_t> packet) { agent.receive(packet); });
+
+    // Controller side
+    ender::CH9329Controller controller(simulator.port_path(), 115200);
+    ender::HidRpcChannel channel(controller);
+    channel.start();
+
+    const std::array<uint8_t, 4> numbers = {1, 2, 3, 250};
+    const auto sum = channel.endpoint().call(METHOD_SUM, numbers);
+    const bool sum_ok = sum && sum->size() == 2 && ((*sum)[0] | (*sum)[1] << 8) == 256;
+    std::cout << "sum(1, 2, 3, 250) " << (sum_ok ? "= 256" : "failed") << std::endl;
+    bool all_ok = sum_ok;
+
+    std::cout << std::fixed << std::setprecision(1);
+    for (const size_t size: {16, 400}) {
+        for (const size_t depth: {1, 8}) {
+            const auto run = bench(channel.endpoint(), calls, depth, size);
+            all_ok = all_ok && run.failures == 0;
+            std::cout << "  " << std::setw(3) << size << " B echo, " << depth << " in flight: " << std::setw(7)
+                      << static_cast<double>(run.calls) / run.seconds << " calls/s, " << run.failures << " failed"
+                      << std::endl;
+        }
+    }
+    channel.stop();
+
+    const auto stats = channel.stats();
+    std::cout << stats.packets_sent << " packets out, " << stats.packets_received << " in, " << stats.retransmits
+              << " resent" << std::endl;
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,63 @@
+#include "DeviceSimulator.hpp"
+#include <ch9329/ScrollEngine.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <iomanip>
+#include <iostream>
+
+// Scrolls a long document on a simulated host: one frame per notch by hand, then each profile of the
+// scroll engine, checking that the host received the full distance and how closely pacing held.
+int main(int argc, char **argv) {
+    const int distance = argc > 1 ? std::stoi(argv[1]) : -600;
+
+    ender::DeviceSimulator simulator;
+    simulator.set_line_rate(115200);
+    ender::asio::io_context io;
+    ender::CH9329Controller controller(io, simulator.port_path(), 115200);
+
+    auto seconds = [](auto d) { return std::chrono::duration<double>(d).count(); };
+    std::cout << std::fixed << std::setprecision(3);
+
+    auto wheel_before = simulator.host_wheel();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < std::abs(distance); ++i) controller.scroll_wheel(distance < 0 ? -1 : 1);
+    std::cout << std::left << std::setw(16) << "by hand" << std::right << std::setw(6) << std::abs(distance)
+              << " frames " << seconds(std::chrono::steady_clock::now() - start) << " s, host got "
+              << simulator.host_wheel() - wheel_before << std::endl;
+
+    struct Case {
+        const char *name;
+        ender::ScrollOptions options;
+    };
+    std::vector<Case> cases(4);
+    cases[0] = {"burst", {}};
+    cases[0].options.interval = {};
+    cases[1] = {"constant", {}};
+    cases[2] = {"ease-out", {}};
+    cases[2].options.profile = ender::ScrollProfile::EaseOut;
+    cases[3] = {"fling", {}};
+    cases[3].options.profile = ender::ScrollProfile::Fling;
+
+    bool all_ok = true;
+    for (const auto &[name, options]: cases) {
+        const auto plan = ender::plan_scroll(distance, options);
+        wheel_before = simulator.host_wheel();
+        bool ok = false;
+        start = std::chrono::steady_clock::now();
+        ender::asio::co_spawn(io, [&]() -> ender::task<void> {
+            ok = co_await ender::co_scroll(controller, plan);
+        }, ender::asio::detached);
+        io.restart();
+        io.run();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        const auto received = simulator.host_wheel() - wheel_before;
+        all_ok = all_ok && ok && received == distance;
+
+        std::cout << std::left << std::setw(16) << name << std::right << std::setw(6) << plan.steps.size()
+                  << " frames " << seconds(elapsed) << " s (planned " << seconds(plan.duration())
+                  << " s), host got " << received << " |";
+        for (const auto &step: plan.steps) std::cout << ' ' << static_cast<int>(step.wheel);
+        std::cout << std::endl;
+    }
+    return all_ok ? 0 : 1;
+}
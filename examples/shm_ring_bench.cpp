@@ -0,0 +1,56 @@
+#include "DeviceSimulator.hpp"
+#include <ch9329/Gateway.hpp>
+#include <ch9329/ShmRing.hpp>
+#include <iostream>
+#include <thread>
+
+// Shared-memory front-end benchmark: producer threads enqueue relative moves into a ring that an
+// in-process gateway drains into a simulated device. Reports the producer-side cost per record.
+int main(int argc, char **argv) {
+    const size_t producers = argc > 1 ? std::stoul(argv[1]) : 4;
+    const size_t records = argc > 2 ? std::stoul(argv[2]) : 50000;
+    const std::string ring_name = "/ch9329-ring-bench";
+
+    ender::DeviceSimulator simulator;
+    ender::asio::io_context io;
+    ender::Gateway gateway(io);
+    gateway.add_device(simulator.port_path(), 115200);
+    gateway.attach_ring(ring_name, 0, 4096);
+
+    std::atomic<uint64_t> push_ns{0};
+    std::atomic<uint64_t> rejected{0};
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; ++p) {
+        threads.emplace_back([&] {
+            ender::ShmRingProducer ring(ring_name);
+            uint64_t spent = 0;
+            for (size_t i = 0; i < records; ++i) {
+                const auto start = std::chrono::steady_clock::now();
+                const bool ok = ring.push_rel_move(0x00, 1, 1);
+                spent += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+                if (!ok) {
+                    ++rejected;
+                    std::this_thread::sleep_for(std::chrono::microseconds(50)); // Ring full: back off
+                }
+            }
+            push_ns += spent;
+        });
+    }
+    for (auto &t: threads) t.join();
+
+    const uint64_t accepted = producers * records - rejected;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (simulator.stats().frames < accepted && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    gateway.stop();
+
+    const auto stats = gateway.stats();
+    std::cout << producers << " producers x " << records << " records\n"
+            << "  " << static_cast<double>(push_ns) / static_cast<double>(producers * records)
+            << " ns per push (incl. rejected), " << rejected << " rejected while the ring was full\n"
+            << "  " << stats.ring_records << " drained, " << simulator.stats().frames << " frames at the device, "
+            << static_cast<double>(stats.ring_records) / static_cast<double>(std::max<uint64_t>(stats.batches, 1))
+            << " records per serial write" << std::endl;
+    return simulator.stats().frames == accepted ? 0 : 1;
+}
@@ -0,0 +1,375 @@
+#include "DeviceSimulator.hpp"
+#include <boost/system/system_error.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <chrono>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <utility>
+
+namespace ender {
+    namespace {
+        constexpr uint8_t RESPONSE_OK = 0x80;
+        constexpr uint8_t RESPONSE_ERROR = 0xC0;
+
+        [[noreturn]] void throw_errno(const char *what) {
+            throw boost::system::system_error(errno, boost::system::system_category(), what);
+        }
+    }
+
+    DeviceSimulator::DeviceSimulator() {
+        master_fd_ = ::posix_openpt(O_RDWR | O_NOCTTY);
+        if (master_fd_ < 0) throw_errno("posix_openpt");
+        if (::grantpt(master_fd_) != 0 || ::unlockpt(master_fd_) != 0) {
+            ::close(master_fd_);
+            throw_errno("grantpt");
+        }
+        port_path_ = ::ptsname(master_fd_);
+
+        slave_fd_ = ::open(port_path_.c_str(), O_RDWR | O_NOCTTY);
+        if (slave_fd_ < 0) {
+            ::close(master_fd_);
+            throw_errno("open pty");
+        }
+        termios tio{};
+        ::tcgetattr(slave_fd_, &tio);
+        ::cfmakeraw(&tio);
+        ::tcsetattr(slave_fd_, TCSANOW, &tio);
+
+        if (::pipe(wake_fds_.data()) != 0) {
+            ::close(slave_fd_);
+            ::close(master_fd_);
+            throw_errno("pipe");
+        }
+        ::fcntl(wake_fds_[0], F_SETFL, O_NONBLOCK);
+        ::fcntl(wake_fds_[1], F_SETFL, O_NONBLOCK);
+
+        usb_strings_ = {"WCH", "CH9329 Simulator", "SIM00000"};
+        thread_ = std::thread([this] { run(); });
+    }
+
+    DeviceSimulator::~DeviceSimulator() {
+        running_.store(false);
+        if (thread_.joinable()) thread_.join();
+        ::close(wake_fds_[0]);
+        ::close(wake_fds_[1]);
+        ::close(slave_fd_);
+        ::close(master_fd_);
+    }
+
+    void DeviceSimulator::set_usb_string(uint8_t type, const std::string &content) {
+        if (type >= usb_strings_.size()) return;
+        std::lock_guard lock(state_mutex_);
+        usb_strings_[type] = content;
+    }
+
+    std::string DeviceSimulator::usb_string(uint8_t type) const {
+        if (type >= usb_strings_.size()) return {};
+        std::lock_guard lock(state_mutex_);
+        return usb_strings_[type];
+    }
+
+    std::array<uint8_t, 50> DeviceSimulator::para_config() const {
+        std::lock_guard lock(state_mutex_);
+        return para_config_;
+    }
+
+    void DeviceSimulator::set_host_latency(std::chrono::microseconds latency, std::chrono::microseconds jitter) {
+        std::lock_guard lock(state_mutex_);
+        host_latency_ = latency;
+        host_jitter_ = jitter;
+        led_toggles_.clear();
+    }
+
+    void DeviceSimulator::set_host_key_rate(double keys_per_second, size_t buffer) {
+        std::lock_guard lock(state_mutex_);
+        host_key_rate_ = std::max(keys_per_second, 0.0);
+        host_buffer_ = static_cast<double>(std::max<size_t>(buffer, 1));
+        host_backlog_ = 0;
+    }
+
+    void DeviceSimulator::host_keyboard_report(std::span<const uint8_t> report) {
+        // Report layout: modifiers, reserved, six key codes
+        std::array<uint8_t, 6> keys{};
+        if (report.size() >= 8) std::copy(report.begin() + 2, report.begin() + 8, keys.begin());
+        const auto now = std::chrono::steady_clock::now();
+        if (host_key_rate_ > 0) {
+            const std::chrono::duration<double> elapsed = now - host_drained_at_;
+            host_backlog_ = std::max(0.0, host_backlog_ - elapsed.count() * host_key_rate_);
+        }
+        host_drained_at_ = now;
+
+        for (const uint8_t key: keys) {
+            if (key == 0 || std::ranges::find(host_keys_, key) != host_keys_.end()) continue;
+
+            // A new press: it waits behind the backlog, or is lost if the host buffer is full
+            auto delay = host_latency_;
+            if (host_key_rate_ > 0) {
+                if (host_backlog_ + 1 > host_buffer_) {
+                    host_dropped_.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                host_backlog_ += 1;
+                delay += std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::duration<double>(host_backlog_ / host_key_rate_));
+            } else if (host_latency_.count() == 0 && host_jitter_.count() == 0) {
+                continue;
+            }
+
+            constexpr std::array<std::pair<uint8_t, uint8_t>, 3> lock_keys = {{{0x53, 0x01}, {0x39, 0x02}, {0x47, 0x04}}};
+            const auto lock_key = std::ranges::find(lock_keys, key, &std::pair<uint8_t, uint8_t>::first);
+            if (lock_key == lock_keys.end()) continue;
+            if (host_jitter_.count() > 0) {
+                delay += std::chrono::microseconds(host_rng_() % (host_jitter_.count() + 1));
+            }
+            led_toggles_.push_back({now + delay, lock_key->second});
+        }
+        host_keys_ = keys;
+    }
+
+    void DeviceSimulator::set_host_pointer(uint32_t width, uint32_t height, PointerCurve curve) {
+        std::lock_guard lock(state_mutex_);
+        host_width_ = std::max<uint32_t>(width, 1);
+        host_height_ = std::max<uint32_t>(height, 1);
+        host_curve_ = std::move(curve);
+        host_x_ = std::min(host_x_, host_width_ - 1.0);
+        host_y_ = std::min(host_y_, host_height_ - 1.0);
+    }
+
+    Point DeviceSimulator::host_cursor() const {
+        std::lock_guard lock(state_mutex_);
+        return {static_cast<int32_t>(std::floor(host_x_)), static_cast<int32_t>(std::floor(host_y_))};
+    }
+
+    int64_t DeviceSimulator::host_wheel() const {
+        std::lock_guard lock(state_mutex_);
+        return host_wheel_;
+    }
+
+    void DeviceSimulator::set_hid_failure_rate(double rate) {
+        std::lock_guard lock(state_mutex_);
+        hid_failure_rate_ = std::clamp(rate, 0.0, 1.0);
+    }
+
+    std::vector<uint8_t> DeviceSimulator::take_host_hid() {
+        std::lock_guard lock(state_mutex_);
+        return std::exchange(host_hid_, {});
+    }
+
+    void DeviceSimulator::set_host_hid_handler(HidHandler handler) {
+        std::lock_guard lock(state_mutex_);
+        host_hid_handler_ = std::move(handler);
+    }
+
+    void DeviceSimulator::send_host_hid(std::span<const uint8_t> data) {
+        {
+            std::lock_guard lock(state_mutex_);
+            append_frame(upstream_, static_cast<uint8_t>(protocol::Command::ReadMyHidData) | RESPONSE_OK,
+                         data.first(std::min(data.size(), protocol::MAX_PAYLOAD)));
+        }
+        const uint8_t byte = 1;
+        [[maybe_unused]] const auto n = ::write(wake_fds_[1], &byte, 1);
+    }
+
+    void DeviceSimulator::host_mouse_report(protocol::Command cmd, std::span<const uint8_t> report) {
+        if (cmd == protocol::Command::SendMsAbsData) {
+            // Report layout: report ID, buttons, x (LE16), y (LE16), wheel
+            if (report.size() < 7) return;
+            const uint32_t x = report[2] | report[3] << 8;
+            const uint32_t y = report[4] | report[5] << 8;
+            host_x_ = static_cast<double>(std::min<uint32_t>(x * host_width_ / 4096, host_width_ - 1));
+            host_y_ = static_cast<double>(std::min<uint32_t>(y * host_height_ / 4096, host_height_ - 1));
+            host_wheel_ += static_cast<int8_t>(report[6]);
+            return;
+        }
+        // Report layout: report ID, buttons, dx, dy, wheel
+        if (report.size() < 5) return;
+        const auto move = [this](int8_t counts) {
+            if (counts == 0) return 0.0;
+            const int magnitude = std::abs(static_cast<int>(counts));
+            const double pixels = host_curve_ ? host_curve_(magnitude) : magnitude;
+            return counts < 0 ? -pixels : pixels;
+        };
+        host_x_ = std::clamp(host_x_ + move(static_cast<int8_t>(report[2])), 0.0, host_width_ - 1.0);
+        host_y_ = std::clamp(host_y_ + move(static_cast<int8_t>(report[3])), 0.0, host_height_ - 1.0);
+        host_wheel_ += static_cast<int8_t>(report[4]);
+    }
+
+    void DeviceSimulator::host_apply_toggles() {
+        const auto now = std::chrono::steady_clock::now();
+        std::erase_if(led_toggles_, [this, now](const LedToggle &toggle) {
+            if (toggle.due > now) return false;
+            leds_.fetch_xor(toggle.bit, std::memory_order_relaxed);
+            return true;
+        });
+    }
+
+    DeviceSimulator::Stats DeviceSimulator::stats() const {
+        return {
+            frames_.load(std::memory_order_relaxed),
+            bad_frames_.load(std::memory_order_relaxed),
+            bytes_in_.load(std::memory_order_relaxed),
+            bytes_out_.load(std::memory_order_relaxed),
+            host_dropped_.load(std::memory_order_relaxed)
+        };
+    }
+
+    void DeviceSimulator::run() {
+        std::vector<uint8_t> in;
+        std::vector<uint8_t> out;
+        std::array<uint8_t, 4096> chunk{};
+
+        std::vector<std::vector<uint8_t> > deliveries;
+
+        while (running_.load(std::memory_order_relaxed)) {
+            std::array<pollfd, 2> pfds{{{master_fd_, POLLIN, 0}, {wake_fds_[0], POLLIN, 0}}};
+            if (::poll(pfds.data(), pfds.size(), 20) <= 0) continue;
+            if (pfds[1].revents & POLLIN) {
+                while (::read(wake_fds_[0], chunk.data(), chunk.size()) > 0) {
+                }
+            }
+            ssize_t n = 0;
+            if (pfds[0].revents & POLLIN) {
+                n = ::read(master_fd_, chunk.data(), chunk.size());
+                if (n < 0) n = 0;
+            }
+            bytes_in_.fetch_add(static_cast<uint64_t>(n), std::memory_order_relaxed);
+            in.insert(in.end(), chunk.begin(), chunk.begin() + n);
+
+            // Consume every complete frame; bytes before a frame head are line noise
+            size_t pos = 0;
+            out.clear();
+            while (in.size() - pos >= protocol::FRAME_OVERHEAD) {
+                if (in[pos] != protocol::FRAME_HEAD_1 || in[pos + 1] != protocol::FRAME_HEAD_2) {
+                    ++pos;
+                    continue;
+                }
+                const size_t size = protocol::FRAME_OVERHEAD + in[pos + 4];
+                if (in.size() - pos < size) break;
+                handle_frame(std::span<const uint8_t>(in.data() + pos, size), out);
+                pos += size;
+            }
+            in.erase(in.begin(), in.begin() + static_cast<std::ptrdiff_t>(pos));
+
+            // Host-side agent: handle delivered packets without the state lock, then queue what it sent back
+            HidHandler handler;
+            {
+                std::lock_guard lock(state_mutex_);
+                deliveries.swap(hid_deliveries_);
+                if (!deliveries.empty()) handler = host_hid_handler_;
+            }
+            for (const auto &packet: deliveries) handler(packet);
+            deliveries.clear();
+            {
+                std::lock_guard lock(state_mutex_);
+                out.insert(out.end(), upstream_.begin(), upstream_.end());
+                upstream_.clear();
+            }
+
+            if (out.empty()) continue;
+            std::chrono::microseconds wire_time(turnaround_us_.load(std::memory_order_relaxed));
+            if (const unsigned int baud = line_rate_.load(std::memory_order_relaxed); baud != 0) {
+                // Request and response bytes both cross the emulated UART at 10 bits per byte
+                const auto bits = static_cast<uint64_t>(n + out.size()) * 10;
+                wire_time += std::chrono::microseconds(bits * 1000000 / baud);
+            }
+            if (wire_time.count() > 0) std::this_thread::sleep_for(wire_time);
+            for (size_t written = 0; written < out.size();) {
+                const ssize_t w = ::write(master_fd_, out.data() + written, out.size() - written);
+                if (w < 0) {
+                    if (errno == EINTR || errno == EAGAIN) continue;
+                    break;
+                }
+                written += static_cast<size_t>(w);
+            }
+            bytes_out_.fetch_add(out.size(), std::memory_order_relaxed);
+        }
+    }
+
+    void DeviceSimulator::append_frame(std::vector<uint8_t> &out, uint8_t cmd, std::span<const uint8_t> payload) {
+        const size_t start = out.size();
+        out.insert(out.end(), {
+                       protocol::FRAME_HEAD_1, protocol::FRAME_HEAD_2, protocol::DEVICE_ADDR, cmd,
+                       static_cast<uint8_t>(payload.size())
+                   });
+        out.insert(out.end(), payload.begin(), payload.end());
+        out.push_back(protocol::checksum(std::span<const uint8_t>(out.data() + start, out.size() - start)));
+    }
+
+    void DeviceSimulator::handle_frame(std::span<const uint8_t> frame, std::vector<uint8_t> &out) {
+        const uint8_t cmd = frame[3];
+        const auto data = frame.subspan(protocol::HEADER_SIZE, frame[4]);
+        auto status = [&](CommandStatus s) {
+            const uint8_t byte = static_cast<uint8_t>(s);
+            append_frame(out, cmd | (s == CommandStatus::Success ? RESPONSE_OK : RESPONSE_ERROR), {&byte, 1});
+        };
+
+        if (frame.back() != protocol::checksum(frame.first(frame.size() - 1))) {
+            bad_frames_.fetch_add(1, std::memory_order_relaxed);
+            status(CommandStatus::ChecksumError);
+            return;
+        }
+        frames_.fetch_add(1, std::memory_order_relaxed);
+
+        std::lock_guard lock(state_mutex_);
+        switch (static_cast<protocol::Command>(cmd)) {
+            case protocol::Command::GetInfo: {
+                host_apply_toggles();
+                const std::array<uint8_t, 8> info = {0x30, 0x01, leds_.load(std::memory_order_relaxed), 0, 0, 0, 0, 0};
+                append_frame(out, cmd | RESPONSE_OK, info);
+                return;
+            }
+            case protocol::Command::GetParaCfg:
+                append_frame(out, cmd | RESPONSE_OK, para_config_);
+                return;
+            case protocol::Command::SetParaCfg:
+                if (data.size() != para_config_.size()) return status(CommandStatus::ParameterError);
+                std::ranges::copy(data, para_config_.begin());
+                return status(CommandStatus::Success);
+            case protocol::Command::GetUsbString: {
+                if (data.size() != 1 || data[0] >= usb_strings_.size()) return status(CommandStatus::ParameterError);
+                const auto &str = usb_strings_[data[0]];
+                std::vector<uint8_t> payload = {data[0], static_cast<uint8_t>(str.size())};
+                payload.insert(payload.end(), str.begin(), str.end());
+                append_frame(out, cmd | RESPONSE_OK, payload);
+                return;
+            }
+            case protocol::Command::SetUsbString:
+                if (data.size() < 2 || data[0] >= usb_strings_.size() || data[1] != data.size() - 2) {
+                    return status(CommandStatus::ParameterError);
+                }
+                usb_strings_[data[0]].assign(data.begin() + 2, data.end());
+                return status(CommandStatus::Success);
+            case protocol::Command::SetDefaultCfg:
+                para_config_.fill(0);
+                return status(CommandStatus::Success);
+            case protocol::Command::SendKbGeneralData:
+                host_keyboard_report(data);
+                return status(CommandStatus::Success);
+            case protocol::Command::SendMsAbsData:
+            case protocol::Command::SendMsRelData:
+                host_mouse_report(static_cast<protocol::Command>(cmd), data);
+                return status(CommandStatus::Success);
+            case protocol::Command::SendMyHidData:
+                if (hid_failure_rate_ > 0 &&
+                    std::uniform_real_distribution<double>(0.0, 1.0)(host_rng_) < hid_failure_rate_) {
+                    return status(CommandStatus::OperationFailed);
+                }
+                if (host_hid_handler_) {
+                    hid_deliveries_.emplace_back(data.begin(), data.end());
+                } else {
+                    host_hid_.insert(host_hid_.end(), data.begin(), data.end());
+                }
+                return status(CommandStatus::Success);
+            case protocol::Command::ReadMyHidData:
+                return status(CommandStatus::CmdError);
+            case protocol::Command::SendKbMediaData:
+            case protocol::Command::Reset:
+                return status(CommandStatus::Success);
+        }
+        status(CommandStatus::CmdError);
+    }
+}
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <ch9329/Geometry.hpp>
+#include <ch9329/Protocol.hpp>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ender {
+    /*
+     * ========= Device Simulator (POSIX) ==========
+     */
+
+    /*
+     * @brief Software CH9329 behind a pseudo-terminal, for loopback tests and benchmarks
+     *
+     * Open port_path() with CH9329Controller like a real adapter. Every command is acknowledged; the
+     * configuration and USB string commands read and write simulator state.
+     */
+    class DeviceSimulator {
+    public:
+        /*
+         * @brief Counters updated by the simulator thread
+         */
+        struct Stats {
+            uint64_t frames = 0;
+            uint64_t bad_frames = 0;
+            uint64_t bytes_in = 0;
+            uint64_t bytes_out = 0;
+            uint64_t host_dropped = 0; // Key presses the emulated host lost
+        };
+
+        /*
+         * @brief Create the pseudo-terminal pair and start answering frames
+         * @throws boost::system::system_error if no pseudo-terminal is available
+         */
+        DeviceSimulator();
+
+        /*
+         * @brief Destructor, stops the simulator thread and closes the pseudo-terminal
+         */
+        ~DeviceSimulator();
+
+        DeviceSimulator(const DeviceSimulator &) = delete;
+        DeviceSimulator &operator=(const DeviceSimulator &) = delete;
+
+        /*
+         * @brief Serial device path to open with CH9329Controller
+         */
+        const std::string &port_path() const { return port_path_; }
+
+        /*
+         * @brief Emulate the line time of a real UART at this baud rate (0 = as fast as the pty allows)
+         */
+        void set_line_rate(unsigned int baud_rate) { line_rate_.store(baud_rate, std::memory_order_relaxed); }
+
+        /*
+         * @brief Emulate the delay between a request arriving and its response leaving (device processing
+         *        plus the USB-serial adapter's latency timer); requests that arrive together share it
+         */
+        void set_turnaround(std::chrono::microseconds delay) {
+            turnaround_us_.store(delay.count(), std::memory_order_relaxed);
+        }
+
+        /*
+         * @brief Set the USB string descriptor returned for the given type (0 = manufacturer, 1 = product, 2 = serial)
+         */
+        void set_usb_string(uint8_t type, const std::string &content);
+
+        /*
+         * @brief Current USB string descriptor of the given type
+         */
+        std::string usb_string(uint8_t type) const;
+
+        /*
+         * @brief Current 50-byte parameter configuration
+         */
+        std::array<uint8_t, 50> para_config() const;
+
+        /*
+         * @brief Set the lock LED byte reported by GET_INFO (bit 0 num, bit 1 caps, bit 2 scroll)
+         */
+        void set_led_state(uint8_t leds) { leds_.store(leds, std::memory_order_relaxed); }
+
+        /*
+         * @brief Emulate a host that answers lock-key presses by toggling its LED after a delay
+         *
+         * A newly pressed Num/Caps/Scroll Lock key (0x53/0x39/0x47) in a keyboard report flips the matching
+         * LED bit latency + uniform(0, jitter) later, as GET_INFO sees it. The host is off while latency,
+         * jitter and the key rate are all zero.
+         */
+        void set_host_latency(std::chrono::microseconds latency, std::chrono::microseconds jitter = {});
+
+        /*
+         * @brief Emulate a host that absorbs at most keys_per_second key presses (0 = unlimited)
+         *
+         * Presses queue in a buffer of the given depth that drains at the host rate; presses arriving
+         * while it is full are lost, and a lost lock-key press toggles no LED.
+         */
+        void set_host_key_rate(double keys_per_second, size_t buffer = 8);
+
+        /*
+         * @brief Pixels the host cursor moves for one relative report of the given counts (counts > 0)
+         */
+        using PointerCurve = std::function<double(int counts)>;
+
+        /*
+         * @brief Emulate the host cursor on a width x height screen
+         *
+         * Absolute reports place the cursor at position * size / 4096; relative reports move it by
+         * curve(|counts|) pixels per axis, keeping the sub-pixel remainder like a desktop pointer does.
+         * An empty curve moves one pixel per count.
+         */
+        void set_host_pointer(uint32_t width, uint32_t height, PointerCurve curve = {});
+
+        /*
+         * @brief Current host cursor position in pixels
+         */
+        Point host_cursor() const;
+
+        /*
+         * @brief Sum of all wheel deltas the host has received
+         */
+        int64_t host_wheel() const;
+
+        /*
+         * @brief Reject this fraction of SEND_MY_HID_DATA frames with OperationFailed, as when the host
+         *        is not reading the custom HID endpoint
+         */
+        void set_hid_failure_rate(double rate);
+
+        /*
+         * @brief Custom HID bytes delivered to the host since the last call, in arrival order
+         */
+        std::vector<uint8_t> take_host_hid();
+
+        /*
+         * @brief Receives each custom HID packet the host gets from the device
+         */
+        using HidHandler = std::function<void(std::span<const uint8_t> packet)>;
+
+        /*
+         * @brief Hand custom HID packets to a host-side agent instead of the take_host_hid() buffer
+         *
+         * The handler runs on the simulator thread after the packet is acknowledged and may call
+         * send_host_hid(); an empty handler restores the buffer.
+         */
+        void set_host_hid_handler(HidHandler handler);
+
+        /*
+         * @brief Emulate the host writing custom HID data: the device forwards it unprompted as a
+         *        READ_MY_HID_DATA (0x87) frame
+         */
+        void send_host_hid(std::span<const uint8_t> data);
+
+        /*
+         * @brief Snapshot of the simulator counters
+         */
+        Stats stats() const;
+
+    private:
+        int master_fd_ = -1;
+        int slave_fd_ = -1; // Held open so the master side never sees a hang-up between clients
+        std::array<int, 2> wake_fds_{-1, -1}; // Pipe that wakes the simulator thread for upstream frames
+        std::string port_path_;
+
+        std::atomic<bool> running_{true};
+        std::atomic<unsigned int> line_rate_{0};
+        std::atomic<int64_t> turnaround_us_{0};
+        std::atomic<uint8_t> leds_{0};
+        std::thread thread_;
+
+        mutable std::mutex state_mutex_;
+        std::array<uint8_t, 50> para_config_{};
+        std::array<std::string, 3> usb_strings_;
+
+        // Emulated host (guarded by state_mutex_)
+        struct LedToggle {
+            std::chrono::steady_clock::time_point due;
+            uint8_t bit;
+        };
+
+        std::chrono::microseconds host_latency_{0};
+        std::chrono::microseconds host_jitter_{0};
+        std::minstd_rand host_rng_;
+        std::array<uint8_t, 6> host_keys_{}; // Keys held in the previous keyboard report
+        std::vector<LedToggle> led_toggles_;
+        double host_key_rate_ = 0;
+        double host_buffer_ = 8;
+        double host_backlog_ = 0; // Presses queued in the host
+        std::chrono::steady_clock::time_point host_drained_at_{};
+        uint32_t host_width_ = 1920;
+        uint32_t host_height_ = 1080;
+        PointerCurve host_curve_;
+        double host_x_ = 0; // Cursor position with sub-pixel remainder
+        double host_y_ = 0;
+        int64_t host_wheel_ = 0;
+        double hid_failure_rate_ = 0;
+        std::vector<uint8_t> host_hid_;
+        HidHandler host_hid_handler_;
+        std::vector<std::vector<uint8_t> > hid_deliveries_; // Packets awaiting the handler
+        std::vector<uint8_t> upstream_; // Encoded frames the device still has to send unprompted
+
+        std::atomic<uint64_t> frames_{0};
+        std::atomic<uint64_t> bad_frames_{0};
+        std::atomic<uint64_t> bytes_in_{0};
+        std::atomic<uint64_t> bytes_out_{0};
+        std::atomic<uint64_t> host_dropped_{0};
+
+        void run();
+
+        // Handle one complete request frame and append the response to out
+        void handle_frame(std::span<const uint8_t> frame, std::vector<uint8_t> &out);
+
+        // Schedule LED toggles for lock keys pressed in this report
+        void host_keyboard_report(std::span<const uint8_t> report);
+
+        // Move the host cursor and wheel for an absolute or relative mouse report
+        void host_mouse_report(protocol::Command cmd, std::span<const uint8_t> report);
+
+        // Apply toggles that are due to leds_
+        void host_apply_toggles();
+
+        static void append_frame(std::vector<uint8_t> &out, uint8_t cmd, std::span<const uint8_t> payload);
+    };
+}
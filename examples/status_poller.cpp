@@ -0,0 +1,59 @@
+#include "DeviceSimulator.hpp"
+#include <ch9329/StatusPoller.hpp>
+#include <iostream>
+
+// Input bursts on a simulated 9600 baud device while a poller refreshes the status in the gaps;
+// a second thread reads the published snapshot and measures what a read costs.
+int main() {
+    ender::DeviceSimulator simulator;
+    simulator.set_line_rate(9600);
+    ender::CH9329Controller controller(simulator.port_path(), 9600);
+
+    ender::StatusPoller::Options options;
+    options.interval = std::chrono::milliseconds(100);
+    options.idle_gap = std::chrono::milliseconds(10);
+    options.max_delay = std::chrono::milliseconds(300);
+    ender::StatusPoller poller(controller, options);
+    poller.start();
+
+    std::atomic<bool> done{false};
+    uint64_t reads = 0;
+    double read_ns = 0;
+    std::thread reader([&] {
+        const auto start = std::chrono::steady_clock::now();
+        while (!done.load(std::memory_order_relaxed)) {
+            for (int i = 0; i < 1000; ++i) {
+                const auto snapshot = poller.snapshot();
+                reads += snapshot.valid ? 1 : 0;
+            }
+            std::this_thread::yield();
+        }
+        read_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    });
+
+    size_t moves = 0;
+    size_t failures = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int burst = 0; burst < 20; ++burst) {
+        if (burst == 10) simulator.set_led_state(0x02); // Host turns Caps Lock on
+        for (int i = 0; i < 10; ++i) {
+            if (controller.move_mouse(1, 0)) ++moves; else ++failures;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(40));
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    done = true;
+    reader.join();
+    poller.stop();
+
+    const auto snapshot = poller.snapshot();
+    std::cout << moves << " moves, " << failures << " failures in " << elapsed.count() << " s" << std::endl;
+    std::cout << poller.refreshes() << " status refreshes; caps lock "
+              << (snapshot.info.caps_lock ? "on" : "off") << ", host "
+              << (snapshot.info.usb_connected ? "connected" : "disconnected") << std::endl;
+    std::cout << reads << " snapshot reads, " << (reads ? read_ns / reads : 0) << " ns per read (with yields)"
+              << std::endl;
+    return failures == 0 && snapshot.info.caps_lock ? 0 : 1;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <ch9329/CoordinateMapper.hpp>
+#include <ch9329/Protocol.hpp>
+
+namespace ender {
+    /*
+     * ========= Batch Coordinate Conversion ==========
+     *
+     * Vector kernels for long cursor paths: map virtual desktop points through a CoordinateMapper, clamp
+     * to 0-4095 and optionally pack them straight into encoded SEND_MS_ABS_DATA frames. Results are
+     * identical to CoordinateMapper::map(Point) at every level for points within 2^30 of the desktop.
+     */
+
+    enum class SimdLevel : uint8_t {
+        Scalar,
+        SSE2, // 4 points per step
+        AVX2, // 8 points per step
+    };
+
+    const char *to_string(SimdLevel level);
+
+    /*
+     * @brief Fastest level this CPU supports (detected once)
+     */
+    SimdLevel best_simd_level();
+
+    constexpr size_t ABS_FRAME_SIZE = protocol::request_frame_size_v<protocol::Command::SendMsAbsData>;
+
+    /*
+     * @brief Map points to absolute coordinates; converts min(points.size(), out.size()) points
+     *
+     * Levels the CPU does not support fall back to the best supported one.
+     */
+    void map_points(const CoordinateMapper &mapper, std::span<const Point> points, std::span<AbsolutePoint> out,
+                    SimdLevel level = best_simd_level());
+
+    /*
+     * @brief Map points and write one encoded absolute mouse frame per point, back to back
+     * @param out Receives ABS_FRAME_SIZE bytes per point
+     * @return Number of frames written (limited by the size of out)
+     */
+    size_t encode_abs_frames(const CoordinateMapper &mapper, std::span<const Point> points, std::span<uint8_t> out,
+                             uint8_t buttons = 0, int8_t wheel = 0, SimdLevel level = best_simd_level());
+}
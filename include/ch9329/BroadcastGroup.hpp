@@ -0,0 +1,110 @@
+#pragma once
+
+#include <ch9329/CH9329Controller.hpp>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ender {
+    /*
+     * ========= Synchronized Broadcast ==========
+     */
+
+    /*
+     * @brief Sends the same pre-encoded frames to many controllers at a common deadline
+     *
+     * Controllers are partitioned across worker threads. For each broadcast every worker sleeps until just
+     * before the deadline, spins to it, writes the frames to all of its ports back to back and only then
+     * reads the responses, so the response time of one device never delays the write to another.
+     * The controllers are driven exclusively by the workers; do not call them from elsewhere.
+     */
+    class BroadcastGroup {
+    public:
+        struct Options {
+            size_t threads = 0; // Worker threads (0 = one per hardware thread, at most one per device)
+            std::chrono::microseconds lead{2000}; // Deadline offset used by broadcast() without a deadline
+            std::chrono::microseconds spin{200}; // Busy-wait before the deadline to avoid wake-up jitter
+        };
+
+        /*
+         * @brief Outcome for one device; offsets are measured after the write returned
+         */
+        struct DeviceResult {
+            std::chrono::nanoseconds offset{0}; // Write completion relative to the deadline
+            std::chrono::nanoseconds skew{0}; // Write completion relative to the earliest device
+            size_t responses = 0;
+            bool ok = false; // Written and every frame acknowledged with success
+        };
+
+        struct Report {
+            std::chrono::steady_clock::time_point deadline;
+            std::vector<DeviceResult> devices; // In add() order
+
+            std::chrono::nanoseconds max_skew() const;
+            size_t failures() const;
+        };
+
+        BroadcastGroup();
+
+        explicit BroadcastGroup(const Options &options);
+
+        /*
+         * @brief Destructor, joins the workers
+         */
+        ~BroadcastGroup();
+
+        BroadcastGroup(const BroadcastGroup &) = delete;
+        BroadcastGroup &operator=(const BroadcastGroup &) = delete;
+
+        /*
+         * @brief Add a controller (call before the first broadcast)
+         * @return Device index in reports
+         */
+        size_t add(CH9329Controller &controller);
+
+        size_t size() const { return controllers_.size(); }
+
+        /*
+         * @brief Write the frames to every device at the deadline and collect the acknowledgements
+         * @param frames Back-to-back request frames, encoded once for the whole group
+         * @param frame_count Number of frames in frames
+         */
+        Report broadcast_at(std::chrono::steady_clock::time_point deadline,
+                            std::span<const uint8_t> frames, size_t frame_count);
+
+        /*
+         * @brief Broadcast at now + Options::lead
+         */
+        Report broadcast(std::span<const uint8_t> frames, size_t frame_count);
+
+        Report broadcast(std::span<const uint8_t> frame) { return broadcast(frame, 1); }
+
+    private:
+        struct Job {
+            std::chrono::steady_clock::time_point deadline;
+            std::span<const uint8_t> frames;
+            size_t frame_count = 0;
+            std::vector<std::chrono::steady_clock::time_point> written;
+            std::vector<DeviceResult> *results = nullptr;
+        };
+
+        Options options_;
+        std::vector<CH9329Controller *> controllers_;
+        std::vector<std::thread> workers_;
+
+        std::mutex mutex_;
+        std::condition_variable job_ready_;
+        std::condition_variable job_done_;
+        Job job_;
+        uint64_t generation_ = 0;
+        size_t pending_workers_ = 0;
+        bool stopping_ = false;
+
+        void start_workers();
+
+        void run(size_t worker, size_t worker_count);
+
+        void serve(size_t worker, size_t worker_count);
+    };
+}
@@ -1,16 +1,31 @@
 #pragma once
 
+#include <utility>
 #include <boost/asio.hpp>
+#include <ch9329/Protocol.hpp>
 #include <string>
 #include <vector>
 #include <array>
 #include <chrono>
 #include <optional>
+#include <functional>
+#include <span>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <semaphore>
 
 namespace ender {
     namespace asio = boost::asio;
     using namespace std::chrono_literals;
 
+    /*
+     * @brief Coroutine type of the scripting interface, run on the controller's io_context
+     */
+    template<typename T>
+    using task = asio::awaitable<T>;
+
     /*
      * ========= Enum Definitions ==========
      */
@@ -49,16 +64,11 @@ namespace ender {
     };
 
     /*
-     * @brief Command execution status codes
+     * @brief What happens to the command in flight when the serial link drops
      */
-    enum class CommandStatus : uint8_t {
-        Success = 0x00,
-        Timeout = 0xE1,
-        HeadError = 0xE2,
-        CmdError = 0xE3,
-        ChecksumError = 0xE4,
-        ParameterError = 0xE5,
-        OperationFailed = 0xE6,
+    enum class PendingCommandPolicy : uint8_t {
+        Retry = 0x00, // Re-send the command once the port has been reopened
+        Fail = 0x01, // Report failure to the caller after reconnecting
     };
 
     /*
@@ -66,30 +76,66 @@ namespace ender {
      */
 
     /*
-     * @brief Device basic information
+     * @brief Ownership of a controller's serial port
+     *
+     * A mutex that may be released by a thread other than the one that took it: a coroutine holds the
+     * port across suspensions and can resume on any thread running the io_context. Coroutines park a
+     * Waiter instead of blocking; unlock() hands the port straight to the oldest one.
      */
-    struct DeviceInfo {
-        uint8_t version_major = 0;
-        uint8_t version_minor = 0;
-        bool usb_connected = false;
-        bool num_lock = false;
-        bool caps_lock = false;
-        bool scroll_lock = false;
-        bool pc_sleeping = false;
-    };
+    class PortMutex {
+    public:
+        // A parked lock request, resumed once it owns the port
+        struct Waiter {
+            virtual ~Waiter() = default;
+
+            virtual void resume() = 0;
+        };
+
+        void lock() { gate_.acquire(); }
+
+        bool try_lock() { return gate_.try_acquire(); }
+
+        // Take the port now, or take ownership of waiter and resume it once the port is handed over
+        bool lock_or_park(std::unique_ptr<Waiter> &waiter) {
+            std::lock_guard lock(waiters_mutex_);
+            if (gate_.try_acquire()) return true;
+            waiters_.push_back(std::move(waiter));
+            return false;
+        }
+
+        void unlock() {
+            std::unique_ptr<Waiter> next;
+            {
+                // Released under waiters_mutex_, so lock_or_park() either takes the gate or is seen here
+                std::lock_guard lock(waiters_mutex_);
+                if (waiters_.empty()) {
+                    gate_.release();
+                    return;
+                }
+                next = std::move(waiters_.front());
+                waiters_.pop_front();
+            }
+            next->resume();
+        }
 
-    /*
-     * @brief USB string descriptor configuration content
-     */
-    struct UsbStringDescriptor {
-        std::string content;
+    private:
+        std::binary_semaphore gate_{1};
+        std::mutex waiters_mutex_;
+        std::deque<std::unique_ptr<Waiter> > waiters_;
     };
 
+    using PortLock = std::unique_lock<PortMutex>;
+
     /*
-     * @brief Device parameter configuration data (50 bytes)
+     * @brief Supervised connection settings, used when the USB serial adapter re-enumerates
      */
-    struct ParaConfig {
-        std::array<uint8_t, 50> raw_bytes;
+    struct ReconnectPolicy {
+        bool enabled = true;
+        std::string stable_path; // Optional stable alias (e.g. /dev/serial/by-id/...), tried before the original path
+        unsigned int max_attempts = 10;
+        std::chrono::milliseconds initial_backoff = 100ms;
+        std::chrono::milliseconds max_backoff = 5000ms;
+        PendingCommandPolicy pending = PendingCommandPolicy::Retry;
     };
 
     /*
@@ -103,6 +149,13 @@ namespace ender {
          */
         explicit CH9329Controller(const std::string &port, unsigned int baud_rate = 9600);
 
+        /*
+         * @brief Constructor on a shared io_context, so coroutine scripts for many devices can run on one thread
+         *
+         * The blocking interface runs the io_context itself; do not use it while the io_context is run elsewhere.
+         */
+        CH9329Controller(asio::io_context &io, const std::string &port, unsigned int baud_rate = 9600);
+
         /*
          * @brief Destructor, automatically closes the port
          */
@@ -124,6 +177,37 @@ namespace ender {
          */
         bool send_kb_general_data(KeyboardCtrlKey ctrl, const std::array<uint8_t, 6> &keys = {});
 
+        /*
+         * @brief Type keys one after another: press and release each, modifiers held throughout
+         *
+         * Paced by the keystroke rate limit like every other keyboard report.
+         */
+        bool type_keys(std::span<const uint8_t> keys, KeyboardCtrlKey ctrl = KeyboardCtrlKey{});
+
+        /*
+         * @brief send_kb_general_data() that never waits for the keystroke rate limit
+         * @return Empty if the report presses a new key before keystroke_ready_at() (nothing was sent),
+         *         otherwise whether the report was sent
+         */
+        std::optional<bool> try_send_kb_general_data(KeyboardCtrlKey ctrl, const std::array<uint8_t, 6> &keys = {});
+
+        /*
+         * @brief Earliest time a keyboard report with these keys passes the keystroke rate limit
+         */
+        std::chrono::steady_clock::time_point keystroke_ready_at(const std::array<uint8_t, 6> &keys);
+
+        /*
+         * @brief Limit how fast new key presses reach the host (0 = unlimited)
+         *
+         * A keyboard report that presses a key not held in the previous report waits until 1 / rate
+         * after the last such report. Applies to send_kb_general_data(), co_send_kb_general_data() and
+         * everything built on them (type_keys, KeyboardTracker, TickedInput). The wait happens outside the
+         * port lock; try_send_kb_general_data() skips it. See calibrate_key_rate() for finding the rate.
+         */
+        void set_keystroke_rate(double keys_per_second);
+
+        double keystroke_rate() const { return keystroke_rate_.load(std::memory_order_relaxed); }
+
         /*
          * @brief Send multimedia keyboard data
          */
@@ -296,19 +380,348 @@ namespace ender {
         static std::pair<uint16_t, uint16_t> convert_screen_to_absolute(uint16_t screen_x, uint16_t screen_y,
                                                                         uint16_t screen_width, uint16_t screen_height);
 
+        /*
+         * ========= Raw Frame Interface ==========
+         */
+
+        /*
+         * @brief Called with the request index and the raw response frame (view valid only during the call)
+         */
+        using ResponseHandler = std::function<void(size_t index, std::span<const uint8_t> response)>;
+
+        /*
+         * @brief Pipeline pre-encoded frames: one write for the whole batch, then one response read per frame
+         * @param batch Back-to-back request frames
+         * @param frame_count Number of frames in the batch
+         * @param on_response Receives each response in order
+         * @return Number of responses read; requests past it are unanswered (timeout or link loss), and
+         *         their late responses are drained before the port is used again
+         */
+        size_t send_frames(std::span<const uint8_t> batch, size_t frame_count, const ResponseHandler &on_response);
+
+        /*
+         * @brief First half of send_frames(): write the batch without waiting for responses
+         *
+         * Lets a caller start transactions on many controllers back to back before reading any of them.
+         * Follow with read_responses() for the same frame count, holding lock_port() across both.
+         */
+        bool write_frames(std::span<const uint8_t> batch);
+
+        /*
+         * @brief Second half of send_frames(): read one response per frame written
+         * @return Number of responses read
+         */
+        size_t read_responses(size_t frame_count, const ResponseHandler &on_response);
+
+        /*
+         * @brief Read the next frame from the device, waiting at most wait for it to start
+         *
+         * For frames the device sends unprompted, such as custom HID data from the host (READ_MY_HID_DATA),
+         * interleaved with the ACKs of requests written with write_frames(). Call with lock_port() held.
+         * @return Raw frame, a view valid until the next read; empty if nothing started within wait or the
+         *         frame went to the HID input handler
+         */
+        std::optional<std::span<const uint8_t> > read_frame(std::chrono::microseconds wait);
+
+        /*
+         * @brief Discard frames still arriving after a short batch, until the line stays quiet for quiet
+         *
+         * Late responses to abandoned requests would otherwise be read as the responses of the next batch.
+         * Custom HID input found meanwhile still goes to the HID input handler. Call with lock_port() held.
+         * @return Number of frames discarded
+         */
+        size_t drain_input(std::chrono::microseconds quiet);
+
+        /*
+         * @brief drain_input() with a quiet time of one maximum-size frame at the baud rate plus 10 ms
+         */
+        size_t drain_input();
+
+        /*
+         * @brief Receives the payload of each custom HID packet from the host (view valid only during the call)
+         */
+        using HidInputHandler = std::function<void(std::span<const uint8_t> payload)>;
+
+        /*
+         * @brief Route READ_MY_HID_DATA frames to a handler wherever they turn up: between the responses of
+         *        blocking and coroutine commands, in read_responses() or in read_frame()
+         *
+         * Install before traffic starts; an empty handler turns routing off. The handler runs on the thread
+         * that happened to read the frame, with the port held, so hold lock_port() to swap it while other
+         * threads may be sending commands.
+         */
+        void set_hid_input_handler(HidInputHandler handler) { hid_input_handler_ = std::move(handler); }
+
+        bool has_hid_input_handler() const { return static_cast<bool>(hid_input_handler_); }
+
+        /*
+         * @brief Hold the port across a split write_frames()/read_responses() transaction
+         *
+         * Every other blocking command takes this lock itself; holding it keeps poll_info() out.
+         */
+        PortLock lock_port() { return PortLock(port_mutex_); }
+
+        /*
+         * @brief Take the port only if no command is in flight (check owns_lock())
+         */
+        PortLock try_lock_port() { return PortLock(port_mutex_, std::try_to_lock); }
+
+        /*
+         * @brief GET_INFO on a separate receive buffer, for a status poller running beside the caller's thread
+         *
+         * Call with lock_port() or try_lock_port() held.
+         */
+        std::optional<DeviceInfo> poll_info();
+
+        /*
+         * @brief When the last blocking command finished (poll_info() does not count)
+         */
+        std::chrono::steady_clock::time_point last_activity() const {
+            return std::chrono::steady_clock::time_point(
+                std::chrono::steady_clock::duration(last_activity_.load(std::memory_order_relaxed)));
+        }
+
+        /*
+         * ========= Connection Supervision ==========
+         */
+
+        /*
+         * @brief Set the policy applied when the serial link is lost (EIO/ENODEV)
+         */
+        void set_reconnect_policy(const ReconnectPolicy &policy) { reconnect_policy_ = policy; }
+
+        /*
+         * @brief Get the current reconnect policy
+         */
+        const ReconnectPolicy &reconnect_policy() const { return reconnect_policy_; }
+
+        /*
+         * @brief Close and reopen the serial port with backoff, re-applying the cached serial options
+         * @return true if the port is open again
+         */
+        bool reconnect();
+
+        /*
+         * @brief Whether the last blocking command failed because the adapter went away (EIO/ENODEV)
+         */
+        bool link_lost() const;
+
+        /*
+         * @brief Whether the serial port is currently open
+         */
+        bool is_open() const { return port_.is_open(); }
+
+        /*
+         * @brief Baud rate the port was opened with
+         */
+        unsigned int baud_rate() const { return baud_rate_; }
+
+        /*
+         * @brief Set how long a command waits for its response (default 500 ms)
+         */
+        void set_timeout(std::chrono::milliseconds timeout) { timeout_ = timeout; }
+
+        std::chrono::milliseconds timeout() const { return timeout_; }
+
+        /*
+         * ========= Coroutine Interface ==========
+         *
+         * Start scripts with asio::co_spawn(ctrl.io_context(), script(ctrl), asio::detached) and run the
+         * io_context. Commands from concurrent scripts on one controller are serialised; waits use timers,
+         * so thousands of sequences can share a thread. Link loss is reported as failure; call reconnect()
+         * from outside the io_context.
+         */
+
+        asio::io_context &io_context() { return io_; }
+
+        /*
+         * @brief Suspend the calling script without blocking the thread
+         */
+        task<void> delay(std::chrono::milliseconds duration);
+
+        task<std::optional<DeviceInfo> > co_get_info();
+
+        task<std::optional<UsbStringDescriptor> > co_get_usb_string(UsbStringType type);
+
+        task<bool> co_send_kb_general_data(KeyboardCtrlKey ctrl, const std::array<uint8_t, 6> &keys = {});
+
+        task<bool> co_send_ms_abs_data(MouseButton button, uint16_t x, uint16_t y, int8_t wheel = 0);
+
+        task<bool> co_send_ms_rel_data(MouseButton button, int8_t x_delta, int8_t y_delta, int8_t wheel = 0);
+
+        task<bool> co_mouse_down(MouseButton button = MouseButton::Left);
+
+        task<bool> co_mouse_up(MouseButton button = MouseButton::Left);
+
+        task<bool> co_move_mouse(int8_t x_delta, int8_t y_delta);
+
+        task<bool> co_move_to_absolute(uint16_t x, uint16_t y);
+
+        task<bool> co_click(MouseButton button = MouseButton::Left, uint16_t hold_time_ms = 50);
+
+        task<bool> co_double_click(MouseButton button = MouseButton::Left,
+                                   uint16_t click_interval_ms = 150,
+                                   uint16_t hold_time_ms = 50);
+
+        task<bool> co_click_at_absolute(uint16_t x, uint16_t y,
+                                        MouseButton button = MouseButton::Left,
+                                        uint16_t hold_time_ms = 50);
+
+        task<bool> co_drag_absolute(uint16_t start_x, uint16_t start_y,
+                                    uint16_t end_x, uint16_t end_y,
+                                    MouseButton button = MouseButton::Left);
+
+        task<bool> co_drag_select(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2);
+
     private:
-        asio::io_context io_;
+        std::unique_ptr<asio::io_context> owned_io_;
+        asio::io_context &io_;
         asio::serial_port port_;
-        const std::chrono::milliseconds timeout_ = 500ms;
+        // Runs co_read_exact() reads and their timers, so a timeout cannot cancel a read that already completed
+        asio::strand<asio::io_context::executor_type> port_strand_{asio::make_strand(io_)};
+        std::chrono::milliseconds timeout_ = 500ms;
+
+        const std::string port_path_;
+        const unsigned int baud_rate_;
+        ReconnectPolicy reconnect_policy_;
+        boost::system::error_code last_error_;
+
+        // Keystroke pacing for keyboard reports; everything but the rate is guarded by port_mutex_
+        std::atomic<double> keystroke_rate_{0};
+        std::chrono::steady_clock::duration keystroke_interval_{0};
+        std::chrono::steady_clock::time_point next_keystroke_{}; // Earliest time the next new press may go out
+        std::array<uint8_t, 6> last_kb_keys_{};
+
+        using RxBuffer = std::array<uint8_t, protocol::MAX_FRAME_SIZE>;
+
+        // Receive buffer reused by every read; views returned from it stay valid until the next read
+        RxBuffer rx_buffer_{};
+
+        // Serialises blocking commands, coroutine commands and poll_info(), which reads into its own buffer
+        // and error code
+        PortMutex port_mutex_;
+        RxBuffer status_rx_buffer_{};
+        boost::system::error_code status_error_;
+        std::atomic<std::chrono::steady_clock::rep> last_activity_{0};
+        HidInputHandler hid_input_handler_;
+
+        void apply_serial_options();
+
+        // Reopen the port with backoff (port_mutex_ held)
+        bool reopen();
+
+        void mark_activity();
+
+        std::optional<std::span<const uint8_t> > transact(std::span<const uint8_t> frame, RxBuffer &rx,
+                                                          boost::system::error_code &ec);
+
+        // Write an encoded request frame and return a view of the raw response frame in rx_buffer_
+        // (port_mutex_ held; the view is only valid until the lock is released)
+        std::optional<std::span<const uint8_t> > send_command(std::span<const uint8_t> frame);
+
+        // Whether a keyboard report presses a key the previous report did not hold (port_mutex_ held)
+        bool presses_new_key(const std::array<uint8_t, 6> &keys) const;
+
+        // When a keyboard report may go out; time_point::min() if it presses nothing new (port_mutex_ held)
+        std::chrono::steady_clock::time_point keystroke_due(const std::array<uint8_t, 6> &keys) const;
+
+        // Send a keyboard report and advance the pacing state if it was accepted (port_mutex_ held)
+        bool send_kb_report(KeyboardCtrlKey ctrl, const std::array<uint8_t, 6> &keys);
+
+        // Advance the pacing state after a keyboard report written at sent_at was accepted (port_mutex_ held)
+        void record_kb_report(const std::array<uint8_t, 6> &keys, std::chrono::steady_clock::time_point sent_at);
+
+        // Send a request whose response is a single status byte
+        template<protocol::Command C>
+        bool send_status_command(std::span<const uint8_t> frame);
+
+        // Send a request and decode its response payload before releasing the port
+        template<protocol::Command C>
+        std::optional<protocol::response_t<C> > send_query(std::span<const uint8_t> frame);
+
+        // Read exactly one frame into rx, resynchronising on the frame head (have: header bytes already in rx)
+        std::optional<std::span<const uint8_t> > read_response(RxBuffer &rx, boost::system::error_code &ec,
+                                                               size_t have = 0);
+
+        // read_response() that hands READ_MY_HID_DATA frames to the input handler and reads on
+        std::optional<std::span<const uint8_t> > read_reply(RxBuffer &rx, boost::system::error_code &ec);
+
+        // Pass a READ_MY_HID_DATA frame to the input handler if one is installed
+        bool divert_hid_input(std::span<const uint8_t> frame);
+
+        // Completion handler storage for read_exact(), reused so blocking reads do not allocate
+        struct HandlerMemory {
+            alignas(std::max_align_t) std::array<std::byte, 512> storage;
+            bool in_use = false;
+
+            void *allocate(size_t size);
+
+            void deallocate(void *p);
+        };
+
+        HandlerMemory read_handler_memory_;
+
+        // Fill dst completely or fail once timeout_ expires
+        bool read_exact(std::span<uint8_t> dst, boost::system::error_code &ec);
+
+        bool read_exact(std::span<uint8_t> dst, boost::system::error_code &ec,
+                        std::chrono::steady_clock::duration timeout);
+
+        // A suspended co_lock(), resumed on its own executor when ownership is handed to it
+        struct CoWaiter {
+            virtual ~CoWaiter() = default;
+
+            virtual void resume() = 0;
+        };
+
+        // Serialises coroutine transactions: the owner hands over directly to the oldest waiter. Guarded by
+        // co_mutex_, since scripts may resume on any thread running the io_context
+        std::mutex co_mutex_;
+        bool co_busy_ = false;
+        std::deque<std::unique_ptr<CoWaiter> > co_waiters_;
+
+        task<void> co_lock();
+
+        void co_unlock();
+
+        // Take the port from blocking callers, parking on the PortMutex instead of blocking the io_context
+        task<void> co_lock_port();
+
+        // Owns co_lock() and the port for one coroutine transaction; releases the port, then co_lock()
+        class CoPortGuard {
+        public:
+            void unlock() {
+                if (port_) port_.unlock();
+                co_.reset();
+            }
+
+        private:
+            friend class CH9329Controller;
+
+            struct CoUnlock {
+                void operator()(CH9329Controller *ctrl) const { ctrl->co_unlock(); }
+            };
+
+            // Declared first so it is released last
+            std::unique_ptr<CH9329Controller, CoUnlock> co_;
+            PortLock port_;
+        };
+
+        // co_lock() followed by co_lock_port()
+        task<CoPortGuard> co_lock_all();
 
-        std::optional<std::vector<uint8_t> > send_command(uint8_t cmd, const std::vector<uint8_t> &data = {});
+        // Fill dst completely, giving up at deadline; each read has its own timer on port_strand_
+        task<void> co_read_exact(std::span<uint8_t> dst, std::chrono::steady_clock::time_point deadline,
+                                 boost::system::error_code &ec);
 
-        static std::vector<uint8_t> make_frame(uint8_t addr, uint8_t cmd, const std::vector<uint8_t> &data);
+        // Write a frame and read its response; the response is copied out because the lock is released
+        task<std::optional<protocol::Frame> > co_send_command(std::span<const uint8_t> frame);
 
-        static std::optional<std::vector<uint8_t> > validate_response(const std::vector<uint8_t> &resp,
-                                                                      uint8_t expected_cmd);
+        // co_send_command() with co_lock() and the port already held
+        task<std::optional<protocol::Frame> > co_transact(std::span<const uint8_t> frame);
 
-        std::optional<std::vector<uint8_t> > read_response();
+        template<protocol::Command C>
+        task<bool> co_send_status_command(std::span<const uint8_t> frame);
 
         // Helper function: pack mouse button value
         static uint8_t pack_mouse_button(MouseButton b) { return static_cast<uint8_t>(b); }
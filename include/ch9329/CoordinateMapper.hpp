@@ -0,0 +1,137 @@
+#pragma once
+
+#include <ch9329/Geometry.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace ender {
+    /*
+     * ========= Coordinate Mapping ==========
+     */
+
+    /*
+     * @brief One monitor of the host's virtual desktop
+     */
+    struct Monitor {
+        int32_t x = 0; // Top-left corner in virtual desktop pixels (may be negative)
+        int32_t y = 0;
+        uint32_t width = 0; // Size in physical pixels
+        uint32_t height = 0;
+        double scale = 1.0; // DPI scale: one logical pixel covers this many physical pixels
+    };
+
+    /*
+     * @brief Screen to absolute coordinate mapping with precomputed fixed-point factors
+     *
+     * The absolute range spans the bounding box of all monitors, as hosts map an absolute pointer onto
+     * the whole virtual desktop. Each map is a subtract, multiply and shift per axis; for a single screen
+     * the result equals convert_screen_to_absolute().
+     */
+    class CoordinateMapper {
+    public:
+        static constexpr uint16_t ABSOLUTE_MAX = 4095;
+        static constexpr unsigned int FRACTION_BITS = 32;
+
+        /*
+         * @brief Single screen of the given size
+         */
+        CoordinateMapper(uint32_t width, uint32_t height);
+
+        /*
+         * @brief Virtual desktop made of the given monitors (at least one, none empty)
+         */
+        explicit CoordinateMapper(std::span<const Monitor> monitors);
+
+        /*
+         * @brief Map a point in virtual desktop pixels
+         */
+        AbsolutePoint map(Point p) const {
+            return {map_axis(p.x, x_.origin, x_.factor), map_axis(p.y, y_.origin, y_.factor)};
+        }
+
+        /*
+         * @brief Map a point in a monitor's own logical (DPI-scaled) coordinates, origin at its top-left
+         * @throws std::out_of_range if monitor is not an index into monitors()
+         */
+        AbsolutePoint map(size_t monitor, Point local) const {
+            const auto &m = local_.at(monitor);
+            return {map_local(local.x, m.x_base, m.x_factor), map_local(local.y, m.y_base, m.y_factor)};
+        }
+
+        /*
+         * @brief Map a trajectory in virtual desktop pixels (out must hold points.size() entries)
+         *
+         * Uses the fastest SIMD kernel the CPU supports (see BatchConvert.hpp).
+         */
+        void map(std::span<const Point> points, std::span<AbsolutePoint> out) const;
+
+        std::vector<AbsolutePoint> map(std::span<const Point> points) const;
+
+        /*
+         * @brief Map a trajectory in one monitor's logical coordinates
+         * @throws std::out_of_range if monitor is not an index into monitors()
+         */
+        void map(size_t monitor, std::span<const Point> points, std::span<AbsolutePoint> out) const;
+
+        /*
+         * @brief Monitor containing the virtual desktop point, if any
+         */
+        std::optional<size_t> monitor_at(Point p) const;
+
+        const std::vector<Monitor> &monitors() const { return monitors_; }
+
+        /*
+         * @brief Bounding box of the virtual desktop
+         */
+        Point origin() const { return {x_.origin, y_.origin}; }
+
+        uint32_t width() const { return width_; }
+
+        uint32_t height() const { return height_; }
+
+        /*
+         * @brief Per-axis desktop origin and scale factor, for batch kernels
+         */
+        struct Axis {
+            int32_t origin = 0;
+            uint64_t factor = 0; // ABSOLUTE_MAX / extent in 32.32 fixed point, rounded up
+        };
+
+        const Axis &x_axis() const { return x_; }
+
+        const Axis &y_axis() const { return y_; }
+
+    private:
+
+        struct LocalAxes {
+            uint64_t x_base = 0; // Monitor offset within the desktop, already scaled
+            uint64_t y_base = 0;
+            uint64_t x_factor = 0; // DPI scale * ABSOLUTE_MAX / extent
+            uint64_t y_factor = 0;
+        };
+
+        std::vector<Monitor> monitors_;
+        uint32_t width_ = 0;
+        uint32_t height_ = 0;
+        Axis x_;
+        Axis y_;
+        std::vector<LocalAxes> local_;
+
+        void build();
+
+        static uint16_t map_axis(int32_t v, int32_t origin, uint64_t factor) {
+            const int64_t offset = std::max<int64_t>(static_cast<int64_t>(v) - origin, 0);
+            const uint64_t scaled = (static_cast<uint64_t>(offset) * factor) >> FRACTION_BITS;
+            return static_cast<uint16_t>(std::min<uint64_t>(scaled, ABSOLUTE_MAX));
+        }
+
+        static uint16_t map_local(int32_t v, uint64_t base, uint64_t factor) {
+            // base is already in 32.32 fixed point: add before dropping the fraction
+            const uint64_t scaled = (base + static_cast<uint64_t>(std::max(v, 0)) * factor) >> FRACTION_BITS;
+            return static_cast<uint16_t>(std::min<uint64_t>(scaled, ABSOLUTE_MAX));
+        }
+    };
+}
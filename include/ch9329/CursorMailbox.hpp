@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+
+namespace ender {
+    /*
+     * @brief Absolute cursor state carried through the mailbox
+     */
+    struct AbsoluteCursor {
+        uint16_t x = 0; // 0-4095
+        uint16_t y = 0; // 0-4095
+        uint8_t buttons = 0;
+        int8_t wheel = 0;
+    };
+
+    /*
+     * @brief Single-slot, latest-wins mailbox for absolute cursor positions
+     *
+     * The whole state lives in one lock-free 64-bit word, so a producer posting faster than the link
+     * can carry simply overwrites positions the I/O side has not picked up yet.
+     */
+    class AbsoluteCursorMailbox {
+    public:
+        /*
+         * @brief Publish a new position, replacing any position not yet taken
+         * @return true if an unsent position was overwritten
+         */
+        bool post(const AbsoluteCursor &cursor) {
+            const uint64_t previous = slot_.exchange(pack(cursor), std::memory_order_acq_rel);
+            if ((previous & FULL_BIT) == 0) return false;
+            superseded_.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        /*
+         * @brief Take the newest position, leaving the mailbox empty
+         */
+        std::optional<AbsoluteCursor> take() {
+            const uint64_t word = slot_.exchange(0, std::memory_order_acq_rel);
+            if ((word & FULL_BIT) == 0) return std::nullopt;
+            return unpack(word);
+        }
+
+        /*
+         * @brief Put back a taken position whose report failed, unless a newer one was posted meanwhile
+         * @return true if the position is pending again
+         */
+        bool restore(const AbsoluteCursor &cursor) {
+            uint64_t empty = 0;
+            return slot_.compare_exchange_strong(empty, pack(cursor), std::memory_order_acq_rel);
+        }
+
+        /*
+         * @brief Whether a position is waiting to be sent
+         */
+        bool pending() const { return (slot_.load(std::memory_order_acquire) & FULL_BIT) != 0; }
+
+        /*
+         * @brief Number of positions dropped because a newer one replaced them
+         */
+        uint64_t superseded() const { return superseded_.load(std::memory_order_relaxed); }
+
+    private:
+        static constexpr uint64_t FULL_BIT = 1ull << 63;
+
+        std::atomic<uint64_t> slot_{0};
+        std::atomic<uint64_t> superseded_{0};
+
+        static uint64_t pack(const AbsoluteCursor &c) {
+            return FULL_BIT |
+                   static_cast<uint64_t>(c.x) |
+                   static_cast<uint64_t>(c.y) << 16 |
+                   static_cast<uint64_t>(c.buttons) << 32 |
+                   static_cast<uint64_t>(static_cast<uint8_t>(c.wheel)) << 40;
+        }
+
+        static AbsoluteCursor unpack(uint64_t word) {
+            return {
+                static_cast<uint16_t>(word & 0xFFFF),
+                static_cast<uint16_t>((word >> 16) & 0xFFFF),
+                static_cast<uint8_t>((word >> 32) & 0xFF),
+                static_cast<int8_t>(static_cast<uint8_t>((word >> 40) & 0xFF))
+            };
+        }
+
+        static_assert(std::atomic<uint64_t>::is_always_lock_free);
+    };
+}
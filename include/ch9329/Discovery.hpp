@@ -0,0 +1,50 @@
+#pragma once
+
+#include <ch9329/CH9329Controller.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ender {
+    /*
+     * ========= Device Discovery (POSIX) ==========
+     */
+
+    struct DiscoveryOptions {
+        std::vector<std::string> patterns = {"/dev/ttyUSB*", "/dev/ttyACM*"}; // glob(3) patterns
+        std::vector<std::string> ports; // Probed in addition to the pattern matches
+        std::vector<unsigned int> baud_rates = {9600}; // Tried in order until the device answers
+        std::chrono::milliseconds timeout{100}; // Per command; non-CH9329 ports cost at most this per baud rate
+    };
+
+    struct DiscoveredDevice {
+        std::string path;
+        unsigned int baud_rate = 0;
+        DeviceInfo info{};
+    };
+
+    struct DiscoveryResult {
+        std::map<std::string, DiscoveredDevice> devices; // By USB serial number
+        std::vector<std::string> duplicates; // Ports whose serial number was already taken by a lower path
+        std::vector<std::string> silent; // Ports that could not be opened or did not answer
+
+        /*
+         * @brief Serial number to port path
+         */
+        std::map<std::string, std::string> paths() const;
+    };
+
+    /*
+     * @brief Ports matching the patterns, sorted and without duplicates
+     */
+    std::vector<std::string> candidate_ports(const std::vector<std::string> &patterns);
+
+    /*
+     * @brief Identify CH9329 devices by their USB serial number
+     *
+     * All ports are probed at once from one thread with GET_INFO and GET_USB_STRING(SerialNumber), so the
+     * whole scan takes about one timeout per baud rate however many ports there are. When two ports
+     * report the same serial number the lower path wins, keeping the map stable across scans.
+     */
+    DiscoveryResult discover(const DiscoveryOptions &options = {});
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <ch9329/CH9329Controller.hpp>
+#include <memory>
+#include <string>
+
+namespace ender {
+    /*
+     * ========= Gateway Wire Protocol ==========
+     *
+     * Request: DEVICE | CMD | LEN | PAYLOAD[LEN]     (CMD and PAYLOAD as in protocol::command_table)
+     * Reply:   STATUS | LEN | PAYLOAD[LEN]           (one per request, in request order per connection)
+     *
+     * STATUS is the device status byte (CommandStatus) or one of the gateway codes below. Commands that
+     * return data (GET_INFO, GET_PARA_CFG, GET_USB_STRING) reply Success with the response payload.
+     * READ_MY_HID_DATA is sent by the device only and is refused with BadRequest.
+     * Clients may pipeline any number of requests; the gateway applies backpressure per connection.
+     */
+
+    /*
+     * @brief Reply status codes added by the gateway
+     */
+    enum class GatewayStatus : uint8_t {
+        UnknownDevice = 0xF0,
+        BadRequest = 0xF1,
+        DeviceUnavailable = 0xF2, // No valid response from the device (timeout or link loss)
+    };
+
+    constexpr size_t GATEWAY_REQUEST_HEADER_SIZE = 3;
+    constexpr size_t GATEWAY_REPLY_HEADER_SIZE = 2;
+
+    /*
+     * @brief Multiplexes many socket clients onto one or more controllers
+     *
+     * Each device gets a worker thread that serves clients round-robin, one request per client per turn,
+     * and pipelines up to max_batch requests into a single serial write.
+     */
+    class Gateway {
+    public:
+        struct Options {
+            size_t max_batch = 8; // Requests pipelined per serial write
+            size_t max_in_flight = 64; // Unanswered requests per connection before reading pauses
+        };
+
+        /*
+         * @brief Counters across all devices and connections
+         */
+        struct Stats {
+            uint64_t requests = 0;
+            uint64_t batches = 0;
+            uint64_t failures = 0;
+            uint64_t connections = 0;
+            uint64_t ring_records = 0;
+        };
+
+        /*
+         * @brief Sessions run on the given io_context; run it from as many threads as needed
+         */
+        explicit Gateway(asio::io_context &io);
+
+        Gateway(asio::io_context &io, const Options &options);
+
+        /*
+         * @brief Destructor, stops listening and joins the device workers
+         */
+        ~Gateway();
+
+        Gateway(const Gateway &) = delete;
+        Gateway &operator=(const Gateway &) = delete;
+
+        /*
+         * @brief Open a device and start its worker (call before listening)
+         * @return Device index used in requests
+         */
+        uint8_t add_device(const std::string &port, unsigned int baud_rate = 9600);
+
+        /*
+         * @brief Accept TCP clients
+         * @return Bound port (useful with port 0)
+         */
+        uint16_t listen_tcp(const asio::ip::tcp::endpoint &endpoint);
+
+        /*
+         * @brief Accept clients on a Unix domain socket, replacing a stale socket file
+         */
+        void listen_unix(const std::string &path);
+
+        /*
+         * @brief Create a shared-memory input ring whose records are sent to the given device
+         *
+         * Records need no reply; when the device falls behind they stay in the ring, and producers see
+         * it fill up instead of the gateway queueing without bound.
+         */
+        void attach_ring(const std::string &name, uint8_t device, size_t capacity = 1024);
+
+        /*
+         * @brief Close listeners and connections and stop the device workers
+         */
+        void stop();
+
+        Stats stats() const;
+
+    private:
+        struct State;
+        struct Device;
+        struct Lane;
+        struct Session;
+        struct Listener;
+        struct Ring;
+
+        asio::io_context &io_;
+        std::shared_ptr<State> state_;
+
+        static void accept(asio::io_context &io, const std::shared_ptr<State> &state,
+                           const std::shared_ptr<Listener> &listener);
+    };
+
+    /*
+     * @brief Blocking client for the gateway protocol, over TCP or a Unix domain socket
+     */
+    class GatewayClient {
+    public:
+        struct Reply {
+            uint8_t status = 0;
+            uint8_t size = 0;
+            std::array<uint8_t, protocol::MAX_PAYLOAD> data{};
+
+            std::span<const uint8_t> payload() const { return {data.data(), size}; }
+            bool ok() const { return status == static_cast<uint8_t>(CommandStatus::Success); }
+        };
+
+        explicit GatewayClient(const asio::ip::tcp::endpoint &endpoint);
+
+        explicit GatewayClient(const std::string &unix_path);
+
+        /*
+         * @brief Queue a request without waiting for its reply (pipelining)
+         */
+        bool send(uint8_t device, protocol::Command cmd, std::span<const uint8_t> payload = {});
+
+        /*
+         * @brief Read the next reply, in the order requests were sent
+         */
+        std::optional<Reply> receive();
+
+        /*
+         * @brief Send one request and wait for its reply
+         */
+        std::optional<Reply> call(uint8_t device, protocol::Command cmd, std::span<const uint8_t> payload = {});
+
+    private:
+        asio::io_context io_;
+        asio::generic::stream_protocol::socket socket_;
+    };
+}
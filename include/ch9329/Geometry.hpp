@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+namespace ender {
+    /*
+     * ========= Geometry ==========
+     */
+
+    /*
+     * @brief Position in host screen pixels
+     */
+    struct Point {
+        int32_t x = 0;
+        int32_t y = 0;
+    };
+
+    /*
+     * @brief Position in CH9329 absolute space (0-4095 on both axes)
+     */
+    struct AbsolutePoint {
+        uint16_t x = 0;
+        uint16_t y = 0;
+    };
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <ch9329/CH9329Controller.hpp>
+#include <vector>
+
+namespace ender {
+    /*
+     * ========= Bulk Custom HID Transfer ==========
+     */
+
+    struct HidBulkOptions {
+        size_t window = 4; // SEND_MY_HID_DATA frames written ahead of their ACKs (capped to what the baud rate
+                           // carries within half the controller timeout)
+        unsigned int max_attempts = 4; // Sends per packet before it counts as failed
+    };
+
+    /*
+     * @brief Delivery state of one 64-byte packet
+     */
+    struct HidPacketStatus {
+        uint8_t attempts = 0;
+        bool acknowledged = false;
+    };
+
+    struct HidBulkResult {
+        size_t bytes = 0; // Payload bytes acknowledged by the device
+        size_t retransmits = 0;
+        std::vector<HidPacketStatus> packets; // Per packet, in buffer order
+        std::chrono::microseconds elapsed{0};
+
+        size_t failed() const;
+
+        bool ok() const { return failed() == 0; }
+
+        double bytes_per_second() const;
+    };
+
+    /*
+     * @brief Send a buffer of any size as custom HID packets, keeping up to window frames in flight
+     *
+     * The buffer is cut into MAX_PAYLOAD-byte packets (the last one shorter). Each ACK lets the next
+     * frame go out, so the link never idles on a round trip. A packet the device rejects, or whose ACK
+     * never arrives, is queued again until max_attempts. A resent packet reaches the host after the
+     * packets that followed it, and one whose ACK alone was lost may arrive twice; consumers that need
+     * order or exactly-once delivery number their packets (see HidRpc.hpp).
+     *
+     * Holds the port for the whole transfer.
+     */
+    HidBulkResult send_hid_bulk(CH9329Controller &controller, std::span<const uint8_t> data,
+                                const HidBulkOptions &options = {});
+}
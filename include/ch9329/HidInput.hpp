@@ -0,0 +1,148 @@
+#pragma once
+
+#include <ch9329/CH9329Controller.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace ender {
+    /*
+     * ========= Upstream Custom HID Input ==========
+     */
+
+    /*
+     * @brief Fixed arena of packet buffers, allocated once; acquiring and releasing never allocates
+     */
+    class HidBufferPool {
+    public:
+        /*
+         * @brief One packet held in the arena until released
+         */
+        class Buffer {
+        public:
+            Buffer() = default;
+
+            Buffer(Buffer &&other) noexcept { *this = std::move(other); }
+
+            Buffer &operator=(Buffer &&other) noexcept;
+
+            Buffer(const Buffer &) = delete;
+            Buffer &operator=(const Buffer &) = delete;
+
+            /*
+             * @brief Destructor, releases the buffer if it is still held
+             */
+            ~Buffer() { release(); }
+
+            std::span<const uint8_t> data() const;
+
+            size_t size() const { return size_; }
+
+            explicit operator bool() const { return pool_ != nullptr; }
+
+            /*
+             * @brief Return the slot to the pool; the view from data() is invalid afterwards
+             */
+            void release();
+
+        private:
+            friend class HidBufferPool;
+
+            HidBufferPool *pool_ = nullptr;
+            uint32_t slot_ = 0;
+            uint32_t size_ = 0;
+
+            Buffer(HidBufferPool *pool, uint32_t slot, size_t size)
+                : pool_(pool), slot_(slot), size_(static_cast<uint32_t>(size)) {
+            }
+        };
+
+        explicit HidBufferPool(size_t slots);
+
+        HidBufferPool(const HidBufferPool &) = delete;
+        HidBufferPool &operator=(const HidBufferPool &) = delete;
+
+        /*
+         * @brief Copy a payload (at most MAX_PAYLOAD bytes) into a free slot (safe from any thread)
+         * @return Empty buffer if every slot is held
+         */
+        Buffer acquire(std::span<const uint8_t> payload);
+
+        size_t capacity() const { return storage_.size() / protocol::MAX_PAYLOAD; }
+
+        size_t available() const;
+
+    private:
+        std::vector<uint8_t> storage_;
+        std::vector<uint32_t> free_; // Stack of free slot indexes, never grows past capacity
+        mutable std::mutex mutex_;
+
+        void release(uint32_t slot);
+    };
+
+    /*
+     * @brief Delivers the host's custom HID packets (READ_MY_HID_DATA) as pooled buffers, without polling
+     *
+     * Installs the controller's HID input handler, so packets are picked up wherever they arrive:
+     * between the responses of commands other threads are sending, and by a reader thread that waits
+     * on the port while it is idle. The handler owns each buffer until it releases it (or lets it go out
+     * of scope); while every buffer is held, new packets are counted as dropped. Nothing is allocated
+     * per packet.
+     */
+    class HidInputStream {
+    public:
+        using Handler = std::function<void(HidBufferPool::Buffer packet)>;
+
+        struct Options {
+            size_t buffers = 64;
+            std::chrono::microseconds idle_wait{2000}; // Longest a read holds the idle port for host data
+            std::chrono::microseconds idle_backoff{2000}; // Port left free after a read that found nothing
+        };
+
+        struct Stats {
+            uint64_t packets = 0;
+            uint64_t bytes = 0;
+            uint64_t dropped = 0; // Packets lost because every buffer was held
+        };
+
+        HidInputStream(CH9329Controller &controller, Handler handler);
+
+        HidInputStream(CH9329Controller &controller, Handler handler, const Options &options);
+
+        /*
+         * @brief Destructor, stops the reader thread and removes the controller's HID input handler
+         */
+        ~HidInputStream();
+
+        HidInputStream(const HidInputStream &) = delete;
+        HidInputStream &operator=(const HidInputStream &) = delete;
+
+        /*
+         * @brief Start the reader thread (packets arriving during commands are delivered regardless)
+         */
+        void start();
+
+        void stop();
+
+        HidBufferPool &pool() { return pool_; }
+
+        Stats stats() const;
+
+    private:
+        CH9329Controller &controller_;
+        Handler handler_;
+        const Options options_;
+        HidBufferPool pool_;
+
+        std::atomic<bool> running_{false};
+        std::thread thread_;
+
+        std::atomic<uint64_t> packets_{0};
+        std::atomic<uint64_t> bytes_{0};
+        std::atomic<uint64_t> dropped_{0};
+
+        void deliver(std::span<const uint8_t> payload);
+
+        void run();
+    };
+}
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <ch9329/CH9329Controller.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ender {
+    /*
+     * ========= RPC over Custom HID ==========
+     *
+     * Packet: KIND | ID(LE16) | METHOD | FRAGMENT | FRAGMENTS | LEN | DATA[LEN]     (at most 64 bytes)
+     *
+     * KIND is request, response or error (unknown method or failed handler). A message longer than one
+     * packet is split into up to 255 fragments that share ID and METHOD; the receiver reassembles them by
+     * FRAGMENT index, so fragments may arrive in any order. Responses carry the ID of their request.
+     */
+
+    enum class HidRpcKind : uint8_t {
+        Request = 0x01,
+        Response = 0x02,
+        Error = 0x03,
+    };
+
+    /*
+     * @brief Both ends of the RPC protocol over any packet transport: calls out and serves calls in
+     *
+     * Transport-agnostic: packets leave through the send function and arrive through receive(). Handlers
+     * and completions run on the thread that calls receive() and must not block it.
+     *
+     * Each method runs at most once per request: a served request is remembered for replay_window, and
+     * a resent copy of it (its ACK was lost) is answered with the stored response instead.
+     */
+    class HidRpcEndpoint {
+    public:
+        static constexpr size_t HEADER_SIZE = 7;
+        static constexpr size_t FRAGMENT_SIZE = protocol::MAX_PAYLOAD - HEADER_SIZE;
+        static constexpr size_t MAX_MESSAGE = 255 * FRAGMENT_SIZE;
+
+        using SendPacket = std::function<bool(std::span<const uint8_t> packet)>;
+
+        /*
+         * @brief Serves one method; an empty optional answers with an error packet
+         */
+        using Method = std::function<std::optional<std::vector<uint8_t> >(std::span<const uint8_t> request)>;
+
+        /*
+         * @brief Receives the response, or an empty optional on error or timeout
+         */
+        using Completion = std::function<void(std::optional<std::vector<uint8_t> > response)>;
+
+        struct Options {
+            size_t max_in_flight = 32; // Outstanding calls before call() refuses new ones
+            std::chrono::milliseconds call_timeout{1000};
+            std::chrono::milliseconds replay_window{5000}; // How long a served request's response is kept
+        };
+
+        struct Stats {
+            uint64_t calls = 0;
+            uint64_t completed = 0;
+            uint64_t failed = 0; // Error responses and timeouts
+            uint64_t served = 0;
+            uint64_t replayed = 0; // Resent requests answered from the stored response
+            uint64_t packets_in = 0;
+            uint64_t packets_out = 0;
+            uint64_t bad_packets = 0;
+        };
+
+        explicit HidRpcEndpoint(SendPacket send);
+
+        HidRpcEndpoint(SendPacket send, const Options &options);
+
+        HidRpcEndpoint(const HidRpcEndpoint &) = delete;
+        HidRpcEndpoint &operator=(const HidRpcEndpoint &) = delete;
+
+        /*
+         * @brief Serve a method (bind before the peer starts calling)
+         */
+        void bind(uint8_t method, Method handler);
+
+        /*
+         * @brief Start a call without waiting; done runs exactly once
+         * @return false (done not called) if the request is too large or max_in_flight calls are outstanding
+         */
+        bool call(uint8_t method, std::span<const uint8_t> request, Completion done);
+
+        /*
+         * @brief Call and wait for the response (not from the thread that runs receive())
+         */
+        std::optional<std::vector<uint8_t> > call(uint8_t method, std::span<const uint8_t> request);
+
+        /*
+         * @brief Feed one packet from the transport
+         */
+        void receive(std::span<const uint8_t> packet);
+
+        /*
+         * @brief Fail calls past their deadline, drop stale partial requests and forget old served ones
+         * @return Number of calls failed
+         */
+        size_t expire();
+
+        size_t in_flight() const;
+
+        Stats stats() const;
+
+    private:
+        struct Message {
+            uint8_t method = 0;
+            uint8_t fragments = 0;
+            uint8_t received = 0;
+            std::vector<bool> have;
+            std::vector<uint8_t> data;
+            size_t size = 0;
+        };
+
+        struct Pending {
+            Completion done;
+            std::chrono::steady_clock::time_point deadline;
+            Message response;
+        };
+
+        struct Served {
+            uint8_t method = 0;
+            bool answered = false; // false while the handler runs
+            HidRpcKind kind = HidRpcKind::Error;
+            std::vector<uint8_t> response;
+            std::chrono::steady_clock::time_point finished;
+        };
+
+        SendPacket send_;
+        const Options options_;
+
+        mutable std::mutex mutex_;
+        std::unordered_map<uint8_t, Method> methods_;
+        std::unordered_map<uint16_t, Pending> pending_;
+        std::unordered_map<uint16_t, std::pair<Message, std::chrono::steady_clock::time_point> > requests_;
+        std::unordered_map<uint16_t, Served> served_;
+        uint16_t next_id_ = 0;
+        Stats stats_;
+
+        // Split a message into packets and send them
+        bool send_message(HidRpcKind kind, uint16_t id, uint8_t method, std::span<const uint8_t> data);
+
+        // Store a fragment; true once the message is complete (mutex_ held)
+        static bool assemble(Message &message, uint8_t fragment, uint8_t fragments, std::span<const uint8_t> data);
+    };
+
+    /*
+     * @brief Runs an HidRpcEndpoint over a CH9329: SEND_MY_HID_DATA out, READ_MY_HID_DATA in
+     *
+     * A pump thread owns the controller while running (do not use it from elsewhere): it keeps a window
+     * of packets ahead of their ACKs, resends rejected or unanswered ones, and reads the host's packets
+     * from between the ACKs. Handlers and completions run on the pump thread. The channel reads the
+     * host's packets itself, so the controller must not have an HID input handler installed.
+     */
+    class HidRpcChannel {
+    public:
+        struct Options {
+            size_t window = 4; // Packets written ahead of their ACKs
+            unsigned int max_attempts = 4; // Sends per packet before it is dropped (the call then times out)
+            std::chrono::microseconds idle_wait{1000}; // How long a read waits for host data when nothing is in flight
+            HidRpcEndpoint::Options rpc;
+        };
+
+        struct Stats {
+            uint64_t packets_sent = 0;
+            uint64_t packets_received = 0;
+            uint64_t retransmits = 0;
+            uint64_t dropped = 0;
+        };
+
+        explicit HidRpcChannel(CH9329Controller &controller);
+
+        HidRpcChannel(CH9329Controller &controller, const Options &options);
+
+        /*
+         * @brief Destructor, stops the pump thread
+         */
+        ~HidRpcChannel();
+
+        HidRpcChannel(const HidRpcChannel &) = delete;
+        HidRpcChannel &operator=(const HidRpcChannel &) = delete;
+
+        /*
+         * @brief Start the pump thread
+         * @return false if the controller has an HID input handler, which would take the host's packets
+         */
+        bool start();
+
+        void stop();
+
+        HidRpcEndpoint &endpoint() { return endpoint_; }
+
+        Stats stats() const;
+
+    private:
+        struct Outbound {
+            protocol::Frame frame;
+            unsigned int attempts = 0;
+        };
+
+        CH9329Controller &controller_;
+        const Options options_;
+        HidRpcEndpoint endpoint_;
+
+        std::atomic<bool> running_{false};
+        std::thread thread_;
+
+        mutable std::mutex queue_mutex_;
+        std::deque<Outbound> outbound_;
+
+        std::atomic<uint64_t> packets_sent_{0};
+        std::atomic<uint64_t> packets_received_{0};
+        std::atomic<uint64_t> retransmits_{0};
+        std::atomic<uint64_t> dropped_{0};
+
+        bool enqueue(std::span<const uint8_t> packet);
+
+        void run();
+    };
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <ch9329/CH9329Controller.hpp>
+#include <chrono>
+#include <mutex>
+
+namespace ender {
+    /*
+     * ========= Keyboard State Tracking ==========
+     */
+
+    /*
+     * @brief Controller-side keyboard model shared by concurrent components
+     *
+     * Presses are reference counted, so two components holding the same key do not release it for each
+     * other. Keys keep the 6KRO slot they were assigned and a report is only sent when the effective state
+     * changes.
+     *
+     * With more than six keys held, poll() emulates N-key rollover: the keys that have held a slot longest
+     * are swapped for waiting ones so every held key appears in at least one report per fairness window,
+     * using the minimum ceil(n / 6) reports per window and leaving as many keys as possible in place.
+     *
+     * A report that the controller's keystroke rate limit holds back is not waited for: the call returns
+     * and poll() sends the latest state once next_rotation() is reached.
+     */
+    class KeyboardTracker {
+    public:
+        explicit KeyboardTracker(CH9329Controller &controller);
+
+        KeyboardTracker(const KeyboardTracker &) = delete;
+        KeyboardTracker &operator=(const KeyboardTracker &) = delete;
+
+        /*
+         * @brief Press a key by HID usage code (0xE0-0xE7 map onto the modifier byte)
+         * @return false if a report was needed and could not be sent
+         */
+        bool press(uint8_t key);
+
+        /*
+         * @brief Release one press of a key
+         */
+        bool release(uint8_t key);
+
+        /*
+         * @brief Set the modifier byte held independently of pressed modifier keys
+         */
+        bool set_modifiers(KeyboardCtrlKey ctrl);
+
+        /*
+         * @brief Drop every press and modifier and report an empty keyboard
+         */
+        bool release_all();
+
+        /*
+         * @brief Re-send the current state even if it has not changed (e.g. after a device reset)
+         */
+        bool resend();
+
+        /*
+         * @brief Set how often every held key must appear in a report while more than six are held
+         */
+        void set_fairness_window(std::chrono::milliseconds window);
+
+        /*
+         * @brief Send a report held back by the keystroke rate limit, and rotate slots if more than six keys
+         *        are held and the next rotation is due
+         * @return false if a report could not be sent
+         */
+        bool poll();
+
+        /*
+         * @brief Time at which poll() next has work to do (time_point::max() when nothing is deferred and six
+         *        or fewer keys are held)
+         */
+        std::chrono::steady_clock::time_point next_rotation() const;
+
+        /*
+         * @brief Number of distinct non-modifier keys currently held
+         */
+        size_t held_count() const;
+
+        /*
+         * @brief Effective modifier byte
+         */
+        uint8_t modifiers() const;
+
+        /*
+         * @brief Current 6KRO slot contents (0 = empty slot)
+         */
+        std::array<uint8_t, 6> slots() const;
+
+        /*
+         * @brief Whether the key is held by at least one press
+         */
+        bool is_pressed(uint8_t key) const;
+
+    private:
+        static constexpr uint8_t FIRST_MODIFIER_KEY = 0xE0;
+        static constexpr uint8_t LAST_MODIFIER_KEY = 0xE7;
+
+        CH9329Controller &controller_;
+        mutable std::mutex mutex_;
+
+        std::array<uint8_t, 256> press_count_{};
+        uint8_t explicit_modifiers_ = 0;
+        std::array<uint8_t, 6> slots_{};
+        std::array<uint64_t, 6> slot_order_{}; // When each slot was last filled, for rotation
+        uint64_t fill_counter_ = 0;
+        std::vector<uint8_t> waiting_; // Held keys without a slot, oldest first
+
+        std::chrono::milliseconds fairness_window_{24};
+        std::chrono::steady_clock::time_point last_rotation_{};
+
+        uint8_t sent_modifiers_ = 0;
+        std::array<uint8_t, 6> sent_slots_{};
+        bool deferred_ = false; // The current state is held back by the keystroke rate limit
+        std::chrono::steady_clock::time_point retry_at_{};
+
+        uint8_t effective_modifiers() const;
+
+        void assign_slot(uint8_t key);
+
+        void free_slot(uint8_t key);
+
+        std::chrono::steady_clock::duration rotation_interval() const;
+
+        // Send the current state if it differs from the last report (or always, when forced)
+        bool flush(bool force = false);
+    };
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <ch9329/CH9329Controller.hpp>
+#include <vector>
+
+namespace ender {
+    /*
+     * ========= Host Latency Probe ==========
+     */
+
+    /*
+     * @brief Lock keys whose LED the host echoes back through GET_INFO
+     */
+    enum class LockKey : uint8_t {
+        NumLock = 0x53,
+        CapsLock = 0x39,
+        ScrollLock = 0x47,
+    };
+
+    /*
+     * @brief State of the LED the host drives for a lock key
+     */
+    inline bool lock_led(const DeviceInfo &info, LockKey key) {
+        switch (key) {
+            case LockKey::NumLock: return info.num_lock;
+            case LockKey::CapsLock: return info.caps_lock;
+            case LockKey::ScrollLock: return info.scroll_lock;
+        }
+        return false;
+    }
+
+    /*
+     * @brief One host round trip: key press sent until the LED change was seen
+     *
+     * The change happened between the last poll that still saw the old state and the poll that saw the
+     * new one, so the true latency lies in [lower, upper]; the poll round trip sets the resolution.
+     */
+    struct LatencySample {
+        std::chrono::microseconds lower{0};
+        std::chrono::microseconds upper{0};
+        unsigned int polls = 0;
+
+        std::chrono::microseconds estimate() const { return (lower + upper) / 2; }
+    };
+
+    /*
+     * @brief Distribution of latency estimates over a run
+     */
+    struct LatencyStats {
+        std::vector<LatencySample> samples; // In measurement order
+        size_t lost = 0; // Presses whose echo never arrived within the timeout
+
+        /*
+         * @brief Estimate at the given percentile (0-100), zero without samples
+         */
+        std::chrono::microseconds percentile(double p) const;
+
+        std::chrono::microseconds mean() const;
+
+        /*
+         * @brief Worst poll resolution (upper - lower) in the run
+         */
+        std::chrono::microseconds resolution() const;
+
+        /*
+         * @brief Sample counts per bucket of the given width, starting at zero
+         */
+        std::vector<size_t> histogram(std::chrono::microseconds bucket_width) const;
+    };
+
+    /*
+     * @brief Measures how long the target host takes to process input, by toggling a lock LED
+     *
+     * Each sample presses and releases the lock key, then polls GET_INFO until the host-driven LED flips.
+     * Run it on an idle host session: the probe really toggles the lock state (restored at the end of
+     * run() unless an echo was lost).
+     */
+    class LatencyProbe {
+    public:
+        struct Options {
+            LockKey key = LockKey::NumLock;
+            std::chrono::microseconds poll_interval{0}; // Pause between GET_INFO polls (0 = back to back)
+            std::chrono::milliseconds timeout{1000}; // Give up on one echo after this long
+            std::chrono::milliseconds settle{30}; // Pause between samples
+        };
+
+        explicit LatencyProbe(CH9329Controller &controller);
+
+        LatencyProbe(CH9329Controller &controller, const Options &options);
+
+        /*
+         * @brief Take one sample
+         * @return Sample, or empty optional if the device failed or the echo timed out
+         */
+        std::optional<LatencySample> measure();
+
+        /*
+         * @brief Take the given number of samples and restore the original LED state
+         */
+        LatencyStats run(size_t samples);
+
+    private:
+        CH9329Controller &controller_;
+        const Options options_;
+
+        // Press and release the lock key; returns when the press was written, after any keystroke pacing
+        std::optional<std::chrono::steady_clock::time_point> tap_key();
+    };
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <ch9329/CoordinateMapper.hpp>
+#include <ch9329/PointerAcceleration.hpp>
+#include <vector>
+
+namespace ender {
+    /*
+     * ========= Hybrid Motion Planning ==========
+     */
+
+    /*
+     * @brief Picks absolute or relative reports per movement, whichever reaches the target in fewer bytes
+     *
+     * The planner tracks where it believes the host cursor is, in virtual desktop pixels with the
+     * sub-pixel remainder hosts keep for relative motion. A relative report costs 18 bytes on the wire
+     * (11-byte frame plus its 7-byte ACK) and an absolute one 20, so short hops and jitter go relative
+     * while long jumps go absolute. Where the absolute grid is coarser than a pixel (desktops wider than
+     * 4096 pixels) an absolute jump is followed by relative fix-up reports.
+     *
+     * Hosts are assumed to scale absolute reports as origin + position * extent / 4096. Anything else
+     * that moves the cursor (other code paths, the user's own mouse) must be reported with
+     * set_position() or invalidate(); an unknown position always starts with an absolute jump.
+     */
+    class MotionPlanner {
+    public:
+        static constexpr size_t ABS_WIRE_BYTES =
+            protocol::request_frame_size_v<protocol::Command::SendMsAbsData> + protocol::FRAME_OVERHEAD + 1;
+        static constexpr size_t REL_WIRE_BYTES =
+            protocol::request_frame_size_v<protocol::Command::SendMsRelData> + protocol::FRAME_OVERHEAD + 1;
+
+        /*
+         * @brief Counters across all planned movements
+         */
+        struct Stats {
+            uint64_t moves = 0;
+            uint64_t absolute_frames = 0;
+            uint64_t relative_frames = 0;
+            uint64_t wire_bytes = 0; // Requests plus their ACKs
+        };
+
+        /*
+         * @param mapper Host desktop layout
+         * @param model Host response to relative reports (1:1 by default)
+         */
+        explicit MotionPlanner(const CoordinateMapper &mapper, AccelerationModel model = {});
+
+        /*
+         * @brief Append the frames that bring the cursor to target (desktop pixels) with the given buttons held
+         *
+         * The believed position advances as if the frames were delivered.
+         * @return Number of frames appended (0 when the cursor is already there)
+         */
+        size_t plan(Point target, uint8_t buttons, std::vector<uint8_t> &batch);
+
+        /*
+         * @brief Move the host cursor to target in one pipelined batch
+         * @return false on any missing or failed ACK; the position is then unknown
+         */
+        bool move_to(CH9329Controller &controller, Point target, MouseButton buttons = MouseButton::None);
+
+        /*
+         * @brief Move relative to the believed position (absolute jump from the desktop origin if unknown)
+         */
+        bool move_by(CH9329Controller &controller, int dx, int dy, MouseButton buttons = MouseButton::None);
+
+        /*
+         * @brief Believed cursor pixel, if known
+         */
+        std::optional<Point> position() const;
+
+        void set_position(Point p);
+
+        /*
+         * @brief Forget the position; the next movement starts with an absolute jump
+         */
+        void invalidate() { known_ = false; }
+
+        const Stats &stats() const { return stats_; }
+
+    private:
+        struct Candidate {
+            std::vector<std::pair<int8_t, int8_t> > reports; // Relative reports
+            std::optional<AbsolutePoint> jump; // Absolute report sent before them
+            double x = 0; // Predicted position afterwards
+            double y = 0;
+            size_t bytes = 0;
+        };
+
+        Point origin_;
+        uint32_t width_;
+        uint32_t height_;
+        AccelerationModel model_;
+        bool known_ = false;
+        double x_ = 0;
+        double y_ = 0;
+        uint8_t buttons_ = 0;
+        Stats stats_;
+        std::vector<uint8_t> batch_;
+
+        // Relative reports from (x, y) towards the target pixel, with the predicted landing
+        Candidate relative_from(double x, double y, Point target) const;
+
+        Candidate absolute_to(Point target) const;
+    };
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <ch9329/CH9329Controller.hpp>
+#include <ch9329/CoordinateMapper.hpp>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ender {
+    /*
+     * ========= Pointer Acceleration Compensation ==========
+     */
+
+    /*
+     * @brief Host pointer response: pixels the cursor moves for a relative report of n counts on one axis
+     *
+     * Modelled per report at a steady report rate, sign-symmetric and applied to each axis on its own,
+     * which matches ballistic curves that depend on per-report speed. Between calibration samples the
+     * response is interpolated linearly.
+     */
+    class AccelerationModel {
+    public:
+        /*
+         * @brief Unaccelerated host: one pixel per count
+         */
+        AccelerationModel();
+
+        /*
+         * @param samples (counts, pixels) pairs with counts in 1..127; sorted and made monotonic
+         */
+        explicit AccelerationModel(std::vector<std::pair<int, double> > samples);
+
+        /*
+         * @brief Pixels moved by one report of the given counts
+         */
+        double pixels_for(int counts) const;
+
+        /*
+         * @brief Reports on one axis that move the cursor by the given pixels, fewest reports first
+         *
+         * Uses the largest step that does not overshoot, then a final step chosen so the accumulated
+         * displacement lands as close to the target as the curve allows.
+         */
+        std::vector<int8_t> plan_axis(int pixels) const;
+
+        /*
+         * @brief Reports moving the cursor by (dx, dy) pixels; each axis is planned separately and
+         *        the shorter plan is padded with zero counts
+         */
+        std::vector<std::pair<int8_t, int8_t> > plan(int dx, int dy) const;
+
+        const std::vector<std::pair<int, double> > &samples() const { return samples_; }
+
+        /*
+         * @brief Text form "counts:pixels counts:pixels ..." for persisting a calibration
+         */
+        std::string to_string() const;
+
+        static std::optional<AccelerationModel> parse(const std::string &text);
+
+    private:
+        std::vector<std::pair<int, double> > samples_; // Ascending counts, non-decreasing pixels
+    };
+
+    /*
+     * @brief Reports the host cursor position in pixels (from a host-side agent or a simulator)
+     */
+    using CursorObserver = std::function<std::optional<Point>()>;
+
+    struct AccelerationCalibrationOptions {
+        // Counts per report to sample; dense where desktop curves bend, then every 8 counts
+        std::vector<int> counts = {
+            1, 2, 3, 4, 5, 6, 7, 8, 10, 12, 14, 16, 20, 24, 28, 32, 40, 48, 56, 64, 72, 80, 88, 96, 104, 112, 120, 127
+        };
+        int travel = 128; // Counts sent per sample, spread over as many reports as needed
+        AbsolutePoint start{2048, 2048}; // Absolute position each sample starts from
+        std::chrono::milliseconds settle{50}; // Wait for the host before reading the cursor
+    };
+
+    /*
+     * @brief Measure the host response: from a fixed absolute start, send reports of each count and
+     *        compare where the observer sees the cursor
+     * @return Model, or empty optional if the device or the observer failed
+     */
+    std::optional<AccelerationModel> calibrate_acceleration(CH9329Controller &controller,
+                                                            const CursorObserver &observer,
+                                                            const AccelerationCalibrationOptions &options = {});
+
+    /*
+     * @brief Move the host cursor by (dx, dy) pixels in one pipelined batch planned through the model
+     */
+    bool move_compensated(CH9329Controller &controller, const AccelerationModel &model, int dx, int dy);
+}
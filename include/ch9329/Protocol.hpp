@@ -0,0 +1,413 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+
+namespace ender {
+    /*
+     * @brief Command execution status codes
+     */
+    enum class CommandStatus : uint8_t {
+        Success = 0x00,
+        Timeout = 0xE1,
+        HeadError = 0xE2,
+        CmdError = 0xE3,
+        ChecksumError = 0xE4,
+        ParameterError = 0xE5,
+        OperationFailed = 0xE6,
+    };
+
+    /*
+     * @brief Device basic information
+     */
+    struct DeviceInfo {
+        uint8_t version_major = 0;
+        uint8_t version_minor = 0;
+        bool usb_connected = false;
+        bool num_lock = false;
+        bool caps_lock = false;
+        bool scroll_lock = false;
+        bool pc_sleeping = false;
+    };
+
+    /*
+     * @brief USB string descriptor configuration content
+     */
+    struct UsbStringDescriptor {
+        std::string content;
+    };
+
+    /*
+     * @brief Device parameter configuration data (50 bytes)
+     */
+    struct ParaConfig {
+        std::array<uint8_t, 50> raw_bytes;
+    };
+}
+
+namespace ender::protocol {
+    /*
+     * ========= Frame Layout ==========
+     *
+     * HEAD(0x57 0xAB) | ADDR | CMD | LEN | DATA[LEN] | SUM
+     * SUM is the low byte of the sum of every preceding byte.
+     */
+
+    constexpr uint8_t FRAME_HEAD_1 = 0x57;
+    constexpr uint8_t FRAME_HEAD_2 = 0xAB;
+    constexpr uint8_t DEVICE_ADDR = 0x00;
+
+    constexpr size_t HEADER_SIZE = 5;
+    constexpr size_t FRAME_OVERHEAD = HEADER_SIZE + 1;
+    constexpr size_t MAX_PAYLOAD = 64;
+    constexpr size_t MAX_FRAME_SIZE = FRAME_OVERHEAD + MAX_PAYLOAD;
+
+    // Response CMD byte: request CMD | 0x80 on success, | 0xC0 on error
+    constexpr uint8_t RESPONSE_CMD_MASK = 0x3F;
+    constexpr uint8_t RESPONSE_ERROR_FLAG = 0x40;
+
+    // Marks a request/response whose payload length is only known at runtime
+    inline constexpr size_t variable_length = std::dynamic_extent;
+
+    /*
+     * @brief Protocol command codes
+     */
+    enum class Command : uint8_t {
+        GetInfo = 0x01,
+        SendKbGeneralData = 0x02,
+        SendKbMediaData = 0x03,
+        SendMsAbsData = 0x04,
+        SendMsRelData = 0x05,
+        SendMyHidData = 0x06,
+        ReadMyHidData = 0x07, // Sent by the device unprompted (as 0x87) when the host writes custom HID data
+        GetParaCfg = 0x08,
+        SetParaCfg = 0x09,
+        GetUsbString = 0x0A,
+        SetUsbString = 0x0B,
+        SetDefaultCfg = 0x0C,
+        Reset = 0x0F,
+    };
+
+    /*
+     * @brief Static description of one command: payload lengths on the wire
+     */
+    struct CommandDescriptor {
+        Command code;
+        size_t request_len; // Exact request payload length, or variable_length
+        size_t max_request_len; // Upper bound for variable requests
+        size_t response_len; // Exact response payload length, or variable_length
+        size_t max_response_len; // Upper bound for variable responses
+    };
+
+    /*
+     * @brief The command table. Adding a command is one entry here plus its enumerator.
+     */
+    inline constexpr std::array command_table{
+        CommandDescriptor{Command::GetInfo, 0, 0, 8, 8},
+        CommandDescriptor{Command::SendKbGeneralData, 8, 8, 1, 1},
+        CommandDescriptor{Command::SendKbMediaData, 3, 3, 1, 1},
+        CommandDescriptor{Command::SendMsAbsData, 7, 7, 1, 1},
+        CommandDescriptor{Command::SendMsRelData, 5, 5, 1, 1},
+        CommandDescriptor{Command::SendMyHidData, variable_length, MAX_PAYLOAD, 1, 1},
+        CommandDescriptor{Command::ReadMyHidData, 0, 0, variable_length, MAX_PAYLOAD},
+        CommandDescriptor{Command::GetParaCfg, 0, 0, 50, 50},
+        CommandDescriptor{Command::SetParaCfg, 50, 50, 1, 1},
+        CommandDescriptor{Command::GetUsbString, 1, 1, variable_length, 2 + 23},
+        CommandDescriptor{Command::SetUsbString, variable_length, 2 + 23, 1, 1},
+        CommandDescriptor{Command::SetDefaultCfg, 0, 0, 1, 1},
+        CommandDescriptor{Command::Reset, 0, 0, 1, 1},
+    };
+
+    /*
+     * @brief Look up a command in the table (compile error when used in a constant expression for an unknown code)
+     */
+    constexpr const CommandDescriptor &describe(Command cmd) {
+        for (const auto &d: command_table) {
+            if (d.code == cmd) return d;
+        }
+        throw "command missing from protocol::command_table";
+    }
+
+    template<Command C>
+    inline constexpr CommandDescriptor descriptor_v = describe(C);
+
+    template<Command C>
+    inline constexpr bool fixed_request_v = descriptor_v<C>.request_len != variable_length;
+
+    template<Command C>
+    inline constexpr size_t request_frame_size_v = FRAME_OVERHEAD + descriptor_v<C>.request_len;
+
+    // Payload view type returned by decode<C>(): statically sized when the table fixes the length
+    template<Command C>
+    using response_view_t = std::span<const uint8_t, descriptor_v<C>.response_len>;
+
+    template<Command C>
+    using request_payload_t = std::array<uint8_t, descriptor_v<C>.request_len>;
+
+    /*
+     * @brief Sum of bytes modulo 256
+     */
+    constexpr uint8_t checksum(std::span<const uint8_t> bytes) {
+        uint8_t sum = 0;
+        for (const uint8_t b: bytes) sum = static_cast<uint8_t>(sum + b);
+        return sum;
+    }
+
+    /*
+     * @brief Frame storage for variable-length requests
+     */
+    struct Frame {
+        std::array<uint8_t, MAX_FRAME_SIZE> bytes{};
+        size_t size = 0;
+
+        std::span<const uint8_t> view() const { return {bytes.data(), size}; }
+    };
+
+    /*
+     * @brief Encode a fixed-length request into a frame (usable in constant expressions)
+     */
+    template<Command C> requires fixed_request_v<C>
+    constexpr std::array<uint8_t, request_frame_size_v<C> > encode(const request_payload_t<C> &payload = {}) {
+        std::array<uint8_t, request_frame_size_v<C> > frame{};
+        frame[0] = FRAME_HEAD_1;
+        frame[1] = FRAME_HEAD_2;
+        frame[2] = DEVICE_ADDR;
+        frame[3] = static_cast<uint8_t>(C);
+        frame[4] = static_cast<uint8_t>(payload.size());
+        for (size_t i = 0; i < payload.size(); ++i) frame[HEADER_SIZE + i] = payload[i];
+        frame.back() = checksum(std::span<const uint8_t>(frame.data(), frame.size() - 1));
+        return frame;
+    }
+
+    /*
+     * @brief Find the table entry for a raw command byte
+     * @return nullptr for codes not in the table
+     */
+    constexpr const CommandDescriptor *find_descriptor(uint8_t code) {
+        for (const auto &d: command_table) {
+            if (static_cast<uint8_t>(d.code) == code) return &d;
+        }
+        return nullptr;
+    }
+
+    /*
+     * @brief Encode a request for a command only known at runtime, checking the payload length against the table
+     */
+    inline std::optional<Frame> encode_frame(const CommandDescriptor &d, std::span<const uint8_t> payload) {
+        if (d.request_len != variable_length ? payload.size() != d.request_len
+                                             : payload.size() > d.max_request_len) {
+            return std::nullopt;
+        }
+        Frame frame;
+        frame.bytes[0] = FRAME_HEAD_1;
+        frame.bytes[1] = FRAME_HEAD_2;
+        frame.bytes[2] = DEVICE_ADDR;
+        frame.bytes[3] = static_cast<uint8_t>(d.code);
+        frame.bytes[4] = static_cast<uint8_t>(payload.size());
+        std::ranges::copy(payload, frame.bytes.begin() + HEADER_SIZE);
+        frame.size = FRAME_OVERHEAD + payload.size();
+        frame.bytes[frame.size - 1] = checksum(std::span<const uint8_t>(frame.bytes.data(), frame.size - 1));
+        return frame;
+    }
+
+    /*
+     * @brief Encode a variable-length request, rejecting payloads longer than the table allows
+     */
+    template<Command C> requires (!fixed_request_v<C>)
+    std::optional<Frame> encode(std::span<const uint8_t> payload) {
+        return encode_frame(descriptor_v<C>, payload);
+    }
+
+    /*
+     * @brief Check head, address, command and checksum of a response frame
+     * @return View of the payload inside the frame
+     */
+    constexpr std::optional<std::span<const uint8_t> > validate_frame(std::span<const uint8_t> frame,
+                                                                      Command expected) {
+        if (frame.size() < FRAME_OVERHEAD) return std::nullopt;
+        if (frame[0] != FRAME_HEAD_1 || frame[1] != FRAME_HEAD_2) return std::nullopt;
+        if (frame[2] != DEVICE_ADDR) return std::nullopt;
+        if ((frame[3] & RESPONSE_CMD_MASK) != static_cast<uint8_t>(expected)) return std::nullopt;
+        if (frame.size() != FRAME_OVERHEAD + frame[4]) return std::nullopt;
+        if (frame.back() != checksum(frame.first(frame.size() - 1))) return std::nullopt;
+        return frame.subspan(HEADER_SIZE, frame[4]);
+    }
+
+    /*
+     * @brief Validate a response frame against the table entry for C
+     * @return Payload view into the frame, sized statically when the response length is fixed
+     */
+    template<Command C>
+    constexpr std::optional<response_view_t<C> > decode(std::span<const uint8_t> frame) {
+        const auto payload = validate_frame(frame, C);
+        if (!payload) return std::nullopt;
+        constexpr auto &d = descriptor_v<C>;
+        if constexpr (d.response_len != variable_length) {
+            if (payload->size() != d.response_len) return std::nullopt;
+            return response_view_t<C>(payload->data(), d.response_len);
+        } else {
+            if (payload->size() > d.max_response_len) return std::nullopt;
+            return *payload;
+        }
+    }
+
+    /*
+     * @brief Whether a one-byte status response reports success
+     */
+    constexpr bool is_success(std::span<const uint8_t, 1> status) {
+        return status[0] == static_cast<uint8_t>(CommandStatus::Success);
+    }
+
+    /*
+     * ========= Typed Responses ==========
+     *
+     * response_traits<C> gives the field layout of a response payload and decodes it into a typed value;
+     * decode_as<C>() validates the frame against the table first. Add a specialisation next to the table
+     * entry for each command whose response carries more than a status byte.
+     */
+
+    template<Command C>
+    struct response_traits;
+
+    template<>
+    struct response_traits<Command::GetInfo> {
+        using type = DeviceInfo;
+
+        static constexpr size_t VERSION = 0; // High nibble: major version + 2, low nibble: minor version
+        static constexpr size_t USB_STATUS = 1; // 0x01 once the host has enumerated the device
+        static constexpr size_t LOCK_LEDS = 2; // Bit 0 Num Lock, bit 1 Caps Lock, bit 2 Scroll Lock
+        static constexpr size_t HOST_STATE = 3; // 0x03 while the host is asleep
+
+        static constexpr std::optional<type> parse(response_view_t<Command::GetInfo> payload) {
+            DeviceInfo info{};
+            const uint8_t version = payload[VERSION];
+            info.version_major = ((version >> 4) & 0x0F) - 2;
+            info.version_minor = version & 0x0F;
+            info.usb_connected = payload[USB_STATUS] == 0x01;
+            info.num_lock = (payload[LOCK_LEDS] & 0x01) != 0;
+            info.caps_lock = (payload[LOCK_LEDS] & 0x02) != 0;
+            info.scroll_lock = (payload[LOCK_LEDS] & 0x04) != 0;
+            info.pc_sleeping = payload[HOST_STATE] == 0x03;
+            return info;
+        }
+    };
+
+    template<>
+    struct response_traits<Command::GetParaCfg> {
+        using type = ParaConfig;
+
+        static constexpr std::optional<type> parse(response_view_t<Command::GetParaCfg> payload) {
+            ParaConfig config{};
+            std::ranges::copy(payload, config.raw_bytes.begin());
+            return config;
+        }
+    };
+
+    template<>
+    struct response_traits<Command::GetUsbString> {
+        using type = UsbStringDescriptor;
+
+        static constexpr size_t STRING_TYPE = 0;
+        static constexpr size_t STRING_LENGTH = 1;
+        static constexpr size_t STRING = 2; // STRING_LENGTH bytes, not terminated
+
+        static std::optional<type> parse(response_view_t<Command::GetUsbString> payload) {
+            if (payload.size() < STRING || payload[STRING_LENGTH] != payload.size() - STRING) return std::nullopt;
+            return UsbStringDescriptor{std::string(payload.begin() + STRING, payload.end())};
+        }
+    };
+
+    template<Command C>
+    using response_t = typename response_traits<C>::type;
+
+    /*
+     * @brief Validate a response frame and decode its payload into response_t<C>
+     */
+    template<Command C>
+    constexpr std::optional<response_t<C> > decode_as(std::span<const uint8_t> frame) {
+        const auto payload = decode<C>(frame);
+        if (!payload) return std::nullopt;
+        return response_traits<C>::parse(*payload);
+    }
+
+    /*
+     * ========= Typed Request Payloads ==========
+     */
+
+    constexpr request_payload_t<Command::SendKbGeneralData> kb_general_payload(
+        uint8_t modifiers, const std::array<uint8_t, 6> &keys) {
+        return {modifiers, 0x00, keys[0], keys[1], keys[2], keys[3], keys[4], keys[5]};
+    }
+
+    constexpr request_payload_t<Command::SendKbMediaData> kb_media_payload(uint8_t report_id, uint16_t keycode) {
+        return {report_id, static_cast<uint8_t>(keycode & 0xFF), static_cast<uint8_t>((keycode >> 8) & 0xFF)};
+    }
+
+    constexpr request_payload_t<Command::SendMsAbsData> ms_abs_payload(uint8_t buttons, uint16_t x, uint16_t y,
+                                                                       int8_t wheel) {
+        return {
+            0x02, // Report ID for absolute mouse
+            buttons,
+            static_cast<uint8_t>(x & 0xFF),
+            static_cast<uint8_t>((x >> 8) & 0xFF),
+            static_cast<uint8_t>(y & 0xFF),
+            static_cast<uint8_t>((y >> 8) & 0xFF),
+            static_cast<uint8_t>(wheel)
+        };
+    }
+
+    constexpr request_payload_t<Command::SendMsRelData> ms_rel_payload(uint8_t buttons, int8_t x_delta,
+                                                                       int8_t y_delta, int8_t wheel) {
+        return {
+            0x01, // Report ID for relative mouse
+            buttons,
+            static_cast<uint8_t>(x_delta),
+            static_cast<uint8_t>(y_delta),
+            static_cast<uint8_t>(wheel)
+        };
+    }
+}
+
+namespace ender::protocol::frames {
+    /*
+     * ========= Pre-encoded Frames ==========
+     *
+     * Byte-identical requests are encoded (checksum included) at compile time, so sending them is a plain write.
+     */
+
+    inline constexpr auto get_info = encode<Command::GetInfo>();
+    inline constexpr auto get_para_config = encode<Command::GetParaCfg>();
+    inline constexpr auto set_default_config = encode<Command::SetDefaultCfg>();
+    inline constexpr auto reset = encode<Command::Reset>();
+
+    // Relative mouse report with no buttons, movement or wheel (mouse_up, hover)
+    inline constexpr auto ms_release = encode<Command::SendMsRelData>(ms_rel_payload(0x00, 0, 0, 0));
+
+    template<size_t N, typename Make>
+    constexpr auto make_table(Make make) {
+        std::array<decltype(make(size_t{})), N> table{};
+        for (size_t i = 0; i < N; ++i) table[i] = make(i);
+        return table;
+    }
+
+    /*
+     * @brief Relative mouse reports holding each combination of left/right/middle buttons, without movement
+     */
+    inline constexpr auto ms_buttons = make_table<8>([](size_t mask) {
+        return encode<Command::SendMsRelData>(ms_rel_payload(static_cast<uint8_t>(mask), 0, 0, 0));
+    });
+
+    /*
+     * @brief Keyboard reports pressing a single key without modifiers, indexed by HID usage code
+     *
+     * Entry 0 is the report with every key and modifier released.
+     */
+    inline constexpr auto kb_single_key = make_table<256>([](size_t key) {
+        return encode<Command::SendKbGeneralData>(kb_general_payload(0x00, {static_cast<uint8_t>(key)}));
+    });
+}
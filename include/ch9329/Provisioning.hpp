@@ -0,0 +1,92 @@
+#pragma once
+
+#include <ch9329/CH9329Controller.hpp>
+#include <string>
+#include <vector>
+
+namespace ender {
+    /*
+     * ========= Fleet Provisioning ==========
+     */
+
+    /*
+     * @brief Parameter configuration and USB strings to apply to a set of devices
+     *
+     * Each run of '#' in serial_template is replaced by the device's zero-padded number
+     * (serial_base + target index), e.g. "LAB-####" gives "LAB-0007" for the eighth device of base 0.
+     */
+    struct DeviceProfile {
+        ParaConfig config{};
+        std::string manufacturer;
+        std::string product;
+        std::string serial_template;
+        uint32_t serial_base = 0;
+
+        /*
+         * @brief Serial number string for the device with the given number
+         */
+        std::string serial_for(size_t index) const;
+
+        /*
+         * @brief Baud rate stored in the configuration (bytes 3-6, big-endian); applies after reset
+         */
+        uint32_t baud_rate() const;
+
+        /*
+         * @brief Binary form: "CH9P" | version | 50-byte config | serial base (LE32) | 3 x (LEN | STRING)
+         */
+        std::vector<uint8_t> serialize() const;
+
+        /*
+         * @brief Parse a profile blob
+         * @return Profile, or empty optional if the blob is malformed or a string exceeds 23 bytes
+         */
+        static std::optional<DeviceProfile> parse(std::span<const uint8_t> blob);
+    };
+
+    enum class ProvisionOutcome : uint8_t {
+        AlreadyProvisioned, // Read-compare matched; nothing was written
+        Provisioned, // Written, reset and verified
+        Unreachable, // Port could not be opened or the device did not answer
+        WriteFailed,
+        ResetFailed,
+        VerifyFailed, // The device answered after reset but does not match the profile
+    };
+
+    const char *to_string(ProvisionOutcome outcome);
+
+    struct ProvisionTarget {
+        std::string port;
+        unsigned int baud_rate = 9600; // Baud rate the device currently uses
+    };
+
+    struct ProvisionResult {
+        std::string port;
+        std::string serial; // Serial number assigned to this device
+        ProvisionOutcome outcome = ProvisionOutcome::Unreachable;
+        bool config_written = false;
+        std::array<bool, 3> strings_written{}; // Indexed by UsbStringType
+        std::chrono::milliseconds elapsed{0};
+
+        bool ok() const {
+            return outcome == ProvisionOutcome::AlreadyProvisioned || outcome == ProvisionOutcome::Provisioned;
+        }
+    };
+
+    struct ProvisionOptions {
+        size_t threads = 16; // Devices provisioned concurrently
+        std::chrono::milliseconds reset_settle{500}; // Wait after reset before reopening the port
+        unsigned int verify_attempts = 3; // Reads tried after reset, reset_settle apart
+    };
+
+    /*
+     * @brief Apply a profile to many devices concurrently
+     *
+     * Every device is read first and only the differing parts are written; matching devices are left
+     * alone. Written devices are reset and re-read at the profile's baud rate to verify the result.
+     * @return One result per target, in target order; target i gets serial_for(i)
+     */
+    std::vector<ProvisionResult> provision(const DeviceProfile &profile,
+                                           const std::vector<ProvisionTarget> &targets,
+                                           const ProvisionOptions &options = {});
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <ch9329/LatencyProbe.hpp>
+#include <string>
+#include <vector>
+
+namespace ender {
+    /*
+     * ========= Host Keystroke Rate Calibration ==========
+     */
+
+    struct RateCalibrationOptions {
+        LockKey key = LockKey::NumLock;
+        double start_rate = 10; // Keystrokes per second
+        double max_rate = 500;
+        double step = 1.25; // Rate multiplier between trials
+        size_t burst = 31; // Minimum taps per burst (made odd); bursts per rate use burst, burst + 2, ...
+        size_t host_buffer = 16; // Presses the host may queue before it drops any (assumed upper bound)
+        size_t bursts_per_rate = 3;
+        std::chrono::milliseconds settle{300}; // Wait after a burst for the host to catch up
+        double safety = 0.8; // Fraction of the highest verified rate to use
+    };
+
+    struct RateCalibrationResult {
+        struct Trial {
+            double rate = 0;
+            bool passed = false;
+        };
+
+        std::vector<Trial> trials;
+        double verified_rate = 0; // Highest rate at which every burst was echoed (0 = none, or the device failed)
+        double safe_rate = 0; // verified_rate * safety (0 when nothing verified; not applied)
+
+        bool ok() const { return verified_rate > 0; }
+    };
+
+    /*
+     * @brief Find the fastest keystroke rate the host absorbs without dropping presses
+     *
+     * Ramps the rate geometrically, typing odd-length bursts of lock-key taps through the controller's own
+     * pacing. After each burst the host must have flipped the lock LED: an odd number of lost presses
+     * leaves it unflipped. Bursts of different lengths make an undetected even loss at every trial of a
+     * rate unlikely. The controller's keystroke rate is left at the safe rate; the lock state is restored.
+     * If nothing verifies, or the device stops answering, the controller keeps its earlier rate, or gets
+     * start_rate * safety if it had none: calibration never turns pacing off.
+     *
+     * A host absorbing h keys/s only drops presses typed at r > h once its buffer fills, after
+     * host_buffer / (1 - h / r) presses. Bursts are therefore lengthened to catch any h below the
+     * previous trial rate (r / step), so the verified rate overshoots the host by at most one step.
+     */
+    RateCalibrationResult calibrate_key_rate(CH9329Controller &controller, const RateCalibrationOptions &options = {});
+
+    /*
+     * @brief Calibrated rates per host, persisted as "HOST_ID RATE" lines in a text file
+     */
+    class HostRateStore {
+    public:
+        /*
+         * @brief Store at $XDG_CONFIG_HOME/ch9329/host-rates (or ~/.config/ch9329/host-rates)
+         */
+        HostRateStore();
+
+        explicit HostRateStore(std::string path);
+
+        const std::string &path() const { return path_; }
+
+        std::optional<double> load(const std::string &host_id) const;
+
+        /*
+         * @brief Add or replace the host's rate, creating the file and its directory as needed
+         */
+        bool save(const std::string &host_id, double rate) const;
+
+        /*
+         * @brief Set the controller's keystroke rate to the stored rate for the host
+         * @return false if no rate is stored for the host
+         */
+        bool apply(CH9329Controller &controller, const std::string &host_id) const;
+
+    private:
+        std::string path_;
+    };
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <ch9329/CH9329Controller.hpp>
+#include <vector>
+
+namespace ender {
+    /*
+     * ========= Scroll Engine ==========
+     */
+
+    /*
+     * @brief How a scroll distance is spread over time
+     */
+    enum class ScrollProfile : uint8_t {
+        Constant, // Even speed over the duration
+        EaseOut, // Fast start, cubic slow-down to the end of the duration
+        Fling, // Initial velocity decaying by a fixed factor per report interval, like kinetic scrolling
+    };
+
+    struct ScrollOptions {
+        ScrollProfile profile = ScrollProfile::Constant;
+        std::chrono::microseconds interval{8000}; // Report spacing; 0 sends the fewest frames back to back
+        std::chrono::milliseconds duration{250}; // Constant and EaseOut: time to cover the distance
+        double decay = 0.85; // Fling: fraction of the velocity kept per interval
+        int max_step = 127; // Largest wheel delta per report the host honours (1 for hosts that drop bigger ones)
+    };
+
+    /*
+     * @brief One wheel report, due at an offset from the start of the scroll
+     */
+    struct ScrollStep {
+        int8_t wheel = 0;
+        std::chrono::microseconds at{0};
+    };
+
+    /*
+     * @brief Precomputed wheel reports for one scroll
+     */
+    struct ScrollPlan {
+        std::vector<ScrollStep> steps;
+
+        int total() const;
+
+        std::chrono::microseconds duration() const { return steps.empty() ? std::chrono::microseconds{0} : steps.back().at; }
+    };
+
+    /*
+     * @brief Plan a scroll of distance wheel notches (negative scrolls down)
+     *
+     * The profile gives the cumulative distance due at each interval; a report is emitted only when the
+     * rounded position advances, clamped to max_step with the remainder carried to the next intervals.
+     * Ticks with nothing to send produce no frame, so slow phases cost no bandwidth. The steps always
+     * add up to distance exactly; INT_MIN is planned as -INT_MAX, so the total stays representable.
+     */
+    ScrollPlan plan_scroll(int distance, const ScrollOptions &options = {});
+
+    /*
+     * @brief Send a plan from the calling thread, sleeping until each step is due
+     *
+     * Steps due at the same time go out as one pipelined batch.
+     * @return false if any report failed
+     */
+    bool scroll(CH9329Controller &controller, const ScrollPlan &plan);
+
+    /*
+     * @brief Coroutine variant paced by timers on the controller's io_context, for controllers constructed
+     *        on a shared io_context
+     *
+     * Deadlines are absolute from the start, so a late report does not delay the rest of the plan.
+     */
+    task<bool> co_scroll(CH9329Controller &controller, ScrollPlan plan);
+}
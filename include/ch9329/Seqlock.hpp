@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace ender {
+    /*
+     * @brief Single-writer sequence lock for small trivially copyable values
+     *
+     * Readers never block the writer and never write shared memory; a read costs two loads of the
+     * sequence plus the copy, and retries only while a store is in progress. The value is held in
+     * relaxed atomic words so concurrent reads and writes are well defined.
+     */
+    template<typename T>
+    class Seqlock {
+        static_assert(std::is_trivially_copyable_v<T>, "Seqlock values are copied byte-wise");
+
+    public:
+        Seqlock() { store(T{}); }
+
+        /*
+         * @brief Publish a new value (one writer at a time)
+         */
+        void store(const T &value) {
+            std::array<uint64_t, WORDS> words{};
+            std::memcpy(words.data(), &value, sizeof(T));
+
+            const uint64_t seq = sequence_.load(std::memory_order_relaxed);
+            sequence_.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (size_t i = 0; i < WORDS; ++i) data_[i].store(words[i], std::memory_order_relaxed);
+            sequence_.store(seq + 2, std::memory_order_release);
+        }
+
+        /*
+         * @brief Consistent copy of the latest value (any number of threads)
+         */
+        T load() const {
+            std::array<uint64_t, WORDS> words;
+            uint64_t before;
+            uint64_t after;
+            do {
+                before = sequence_.load(std::memory_order_acquire);
+                for (size_t i = 0; i < WORDS; ++i) words[i] = data_[i].load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                after = sequence_.load(std::memory_order_relaxed);
+            } while (before != after || (before & 1) != 0);
+
+            // Trivially copyable (asserted above), but default member initializers make T non-trivial;
+            // the copy overwrites them, so it goes through void * to say so
+            T value{};
+            std::memcpy(static_cast<void *>(&value), words.data(), sizeof(T));
+            return value;
+        }
+
+        /*
+         * @brief Number of stores so far
+         */
+        uint64_t version() const { return sequence_.load(std::memory_order_acquire) / 2; }
+
+    private:
+        static constexpr size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+        alignas(64) std::atomic<uint64_t> sequence_{0};
+        std::array<std::atomic<uint64_t>, WORDS> data_{};
+    };
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <ch9329/Protocol.hpp>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+
+namespace ender {
+    /*
+     * ========= Shared-memory Input Ring (POSIX) ==========
+     *
+     * A bounded MPSC ring of fixed-size input records in a named shared-memory object. Producer processes
+     * enqueue with atomics only; the consumer sleeps on a futex doorbell when the ring is empty, and
+     * producers only make the wake-up syscall when the consumer has announced it is sleeping.
+     */
+
+    /*
+     * @brief Kinds of input a ring record carries; the payload is the matching command payload
+     */
+    enum class ShmRecordType : uint8_t {
+        RelMove = 0x01, // SEND_MS_REL_DATA
+        AbsMove = 0x02, // SEND_MS_ABS_DATA
+        KeyState = 0x03, // SEND_KB_GENERAL_DATA
+        MediaKey = 0x04, // SEND_KB_MEDIA_DATA
+        HidBlob = 0x05, // SEND_MY_HID_DATA
+    };
+
+    /*
+     * @brief Command sent for a record type
+     */
+    std::optional<protocol::Command> command_for(ShmRecordType type);
+
+    /*
+     * @brief One ring slot; sequence implements the per-slot handoff between producers and the consumer
+     */
+    struct alignas(16) ShmRecord {
+        std::atomic<uint64_t> sequence;
+        uint8_t type;
+        uint8_t size;
+        std::array<uint8_t, protocol::MAX_PAYLOAD> payload;
+    };
+
+    /*
+     * @brief Mapping header at the start of the shared-memory object
+     */
+    struct ShmRingHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t capacity; // Power of two
+        uint32_t record_size;
+        int32_t owner_pid; // Consumer process; a new consumer only replaces the ring once it has exited
+        alignas(64) std::atomic<uint64_t> head; // Next position producers claim
+        alignas(64) std::atomic<uint64_t> tail; // Next position the consumer reads
+        alignas(64) std::atomic<uint32_t> doorbell; // Futex word bumped to wake the consumer
+        std::atomic<uint32_t> consumer_sleeping;
+        std::atomic<uint64_t> dropped; // Records rejected because the ring was full
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+                  "shared-memory ring needs address-free atomics");
+
+    /*
+     * @brief Producer side: maps an existing ring created by the consumer
+     */
+    class ShmRingProducer {
+    public:
+        /*
+         * @throws boost::system::system_error if the ring does not exist or has an incompatible layout
+         */
+        explicit ShmRingProducer(const std::string &name);
+
+        ~ShmRingProducer();
+
+        ShmRingProducer(const ShmRingProducer &) = delete;
+        ShmRingProducer &operator=(const ShmRingProducer &) = delete;
+
+        /*
+         * @brief Enqueue a record (safe from many threads and processes at once)
+         * @return false if the ring is full or the payload is too large
+         */
+        bool push(ShmRecordType type, std::span<const uint8_t> payload);
+
+        bool push_rel_move(uint8_t buttons, int8_t x_delta, int8_t y_delta, int8_t wheel = 0);
+
+        bool push_abs_move(uint8_t buttons, uint16_t x, uint16_t y, int8_t wheel = 0);
+
+        bool push_key_state(uint8_t modifiers, const std::array<uint8_t, 6> &keys);
+
+        bool push_media_key(uint8_t report_id, uint16_t keycode);
+
+        bool push_hid(std::span<const uint8_t> data);
+
+    private:
+        void *mapping_ = nullptr;
+        size_t mapping_size_ = 0;
+        ShmRingHeader *header_ = nullptr;
+        ShmRecord *records_ = nullptr;
+    };
+
+    /*
+     * @brief Consumer side: creates (or re-creates) the ring and drains it
+     */
+    class ShmRingConsumer {
+    public:
+        using RecordHandler = std::function<void(ShmRecordType type, std::span<const uint8_t> payload)>;
+
+        /*
+         * @param capacity Number of records, rounded up to a power of two
+         * @throws boost::system::system_error if the shared-memory object cannot be created, or (EBUSY) if
+         *         a consumer that is still running owns a ring of that name
+         */
+        ShmRingConsumer(const std::string &name, size_t capacity = 1024);
+
+        /*
+         * @brief Destructor, unmaps and unlinks the ring
+         */
+        ~ShmRingConsumer();
+
+        ShmRingConsumer(const ShmRingConsumer &) = delete;
+        ShmRingConsumer &operator=(const ShmRingConsumer &) = delete;
+
+        /*
+         * @brief Hand up to max_records published records to the handler, oldest first
+         * @return Number of records consumed
+         */
+        size_t drain(const RecordHandler &handler, size_t max_records = SIZE_MAX);
+
+        /*
+         * @brief Sleep until a producer rings the doorbell or the timeout expires
+         * @return true if records are available
+         */
+        bool wait(std::chrono::milliseconds timeout);
+
+        /*
+         * @brief Wake a consumer blocked in wait(), e.g. for shutdown
+         */
+        void notify();
+
+        /*
+         * @brief Records dropped by producers because the ring was full
+         */
+        uint64_t dropped() const { return header_->dropped.load(std::memory_order_relaxed); }
+
+        const std::string &name() const { return name_; }
+
+    private:
+        std::string name_;
+        void *mapping_ = nullptr;
+        size_t mapping_size_ = 0;
+        ShmRingHeader *header_ = nullptr;
+        ShmRecord *records_ = nullptr;
+
+        bool ready() const;
+    };
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <ch9329/CH9329Controller.hpp>
+#include <ch9329/Seqlock.hpp>
+#include <condition_variable>
+#include <thread>
+
+namespace ender {
+    /*
+     * @brief Last device status read by a StatusPoller
+     */
+    struct StatusSnapshot {
+        DeviceInfo info{};
+        std::chrono::steady_clock::time_point refreshed{}; // When info was read
+        bool valid = false; // At least one read succeeded
+        bool stale = false; // The latest attempt failed; info is from an earlier read
+    };
+
+    /*
+     * @brief Refreshes DeviceInfo in the background and publishes it through a seqlock
+     *
+     * Every interval the poller waits for the command stream to go quiet for idle_gap and then sends
+     * GET_INFO, giving up at once if a command starts first. If no gap appears within max_delay the
+     * poll waits for the command in flight instead, so the snapshot is never older than about
+     * interval + max_delay.
+     */
+    class StatusPoller {
+    public:
+        struct Options {
+            std::chrono::milliseconds interval{1000};
+            std::chrono::milliseconds idle_gap{20};
+            std::chrono::milliseconds max_delay{1000};
+        };
+
+        StatusPoller(CH9329Controller &controller, const Options &options);
+
+        explicit StatusPoller(CH9329Controller &controller);
+
+        /*
+         * @brief Destructor, stops the poller thread
+         */
+        ~StatusPoller();
+
+        StatusPoller(const StatusPoller &) = delete;
+        StatusPoller &operator=(const StatusPoller &) = delete;
+
+        void start();
+
+        void stop();
+
+        /*
+         * @brief Latest status, without touching the serial port (callable from any thread)
+         */
+        StatusSnapshot snapshot() const { return snapshot_.load(); }
+
+        /*
+         * @brief Number of snapshots published
+         */
+        uint64_t refreshes() const { return snapshot_.version(); }
+
+    private:
+        CH9329Controller &controller_;
+        const Options options_;
+        Seqlock<StatusSnapshot> snapshot_;
+
+        std::thread thread_;
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        bool running_ = false;
+
+        // Sleep until the deadline or stop(); false once stopping
+        bool sleep_until(std::chrono::steady_clock::time_point deadline);
+
+        void run();
+    };
+}
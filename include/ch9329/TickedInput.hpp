@@ -0,0 +1,138 @@
+#pragma once
+
+#include <ch9329/CH9329Controller.hpp>
+#include <ch9329/CursorMailbox.hpp>
+#include <atomic>
+#include <thread>
+
+namespace ender {
+    /*
+     * ========= Fixed-rate Input Mode ==========
+     */
+
+    /*
+     * @brief Emulates a polled HID device: producers update a lock-free state mailbox and an I/O thread
+     *        emits at most one coalesced report per tick
+     *
+     * The controller is driven exclusively by the tick thread while running; do not call it from elsewhere.
+     */
+    class TickedInput {
+    public:
+        /*
+         * @brief Counters updated by the tick thread
+         */
+        struct Stats {
+            uint64_t ticks = 0;
+            uint64_t reports = 0;
+            uint64_t failures = 0;
+            uint64_t overruns = 0; // Ticks that started late because the previous report took too long
+            uint64_t superseded = 0; // Absolute positions replaced before they were sent
+        };
+
+        /*
+         * @brief Bind to a controller; the rate is reduced to what the controller's baud rate can carry
+         * @param tick_rate_hz Requested polling rate (125/250/500/1000 for real devices)
+         */
+        explicit TickedInput(CH9329Controller &controller, unsigned int tick_rate_hz = 1000);
+
+        /*
+         * @brief Destructor, stops the tick thread
+         */
+        ~TickedInput();
+
+        TickedInput(const TickedInput &) = delete;
+        TickedInput &operator=(const TickedInput &) = delete;
+
+        /*
+         * @brief Start the tick thread
+         */
+        void start();
+
+        /*
+         * @brief Stop the tick thread after the current tick
+         */
+        void stop();
+
+        bool running() const { return running_.load(std::memory_order_relaxed); }
+
+        /*
+         * @brief Effective tick rate after fitting to the baud rate
+         */
+        unsigned int tick_rate() const { return tick_rate_; }
+
+        /*
+         * @brief Highest tick rate at which one report plus its ACK fits into a tick at the given baud rate
+         */
+        static unsigned int max_tick_rate(unsigned int baud_rate);
+
+        /*
+         * @brief Largest standard HID polling rate not above the request that the link can sustain
+         */
+        static unsigned int fit_tick_rate(unsigned int requested_hz, unsigned int baud_rate);
+
+        // === Producer Interface (lock-free, callable from any thread) ===
+
+        /*
+         * @brief Accumulate relative movement; large totals are spread over consecutive ticks
+         */
+        void move(int x_delta, int y_delta);
+
+        /*
+         * @brief Accumulate wheel movement
+         */
+        void scroll(int wheel_delta);
+
+        /*
+         * @brief Press or release mouse buttons (bitwise state is kept per button)
+         */
+        void press_button(MouseButton button);
+        void release_button(MouseButton button);
+
+        /*
+         * @brief Post an absolute position; only the newest one is sent, so latency stays at one tick
+         * @param buttons Buttons held for this report, in addition to those set with press_button()
+         */
+        void move_to_absolute(uint16_t x, uint16_t y, MouseButton buttons = MouseButton::None, int8_t wheel = 0);
+
+        /*
+         * @brief Replace the keyboard state reported on the next keyboard tick
+         */
+        void set_keyboard(KeyboardCtrlKey ctrl, const std::array<uint8_t, 6> &keys = {});
+
+        /*
+         * @brief Snapshot of the tick thread counters
+         */
+        Stats stats() const;
+
+    private:
+        CH9329Controller &controller_;
+        const unsigned int tick_rate_;
+
+        std::atomic<bool> running_{false};
+        std::thread thread_;
+
+        // Mailbox: movement accumulates, button and keyboard state is latest-wins
+        std::atomic<int32_t> x_delta_{0};
+        std::atomic<int32_t> y_delta_{0};
+        std::atomic<int32_t> wheel_delta_{0};
+        std::atomic<uint8_t> buttons_{0};
+        std::atomic<uint64_t> keyboard_{0}; // Modifier byte followed by six key slots
+        AbsoluteCursorMailbox absolute_;
+
+        // Tick thread state
+        uint8_t sent_buttons_ = 0;
+        uint64_t sent_keyboard_ = 0;
+        bool keyboard_first_ = true;
+
+        std::atomic<uint64_t> ticks_{0};
+        std::atomic<uint64_t> reports_{0};
+        std::atomic<uint64_t> failures_{0};
+        std::atomic<uint64_t> overruns_{0};
+
+        void run();
+
+        bool tick_keyboard();
+
+        bool tick_mouse();
+    };
+}
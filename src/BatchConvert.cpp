@@ -0,0 +1,174 @@
+#include <ch9329/BatchConvert.hpp>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define CH9329_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace ender {
+    static_assert(sizeof(Point) == 8 && sizeof(AbsolutePoint) == 4, "kernels load points as packed lanes");
+
+    namespace {
+        constexpr size_t CHUNK = 256; // Points mapped per step of encode_abs_frames
+
+        void map_scalar(const CoordinateMapper &mapper, const Point *in, AbsolutePoint *out, size_t n) {
+            for (size_t i = 0; i < n; ++i) out[i] = mapper.map(in[i]);
+        }
+
+#ifdef CH9329_X86_KERNELS
+        // Offsets are clamped to [0, 0xFFFF] first: anything past the desktop maps beyond 4095 anyway, and
+        // the 32.32 factor then splits into two 32x32->64 multiplies: (v * hi) + (v * lo >> 32)
+
+        struct Factors128 {
+            __m128i origin, x_lo, x_hi, y_lo, y_hi;
+        };
+
+        struct Factors256 {
+            __m256i origin, x_lo, x_hi, y_lo, y_hi;
+        };
+
+        __attribute__((target("sse2")))
+        inline __m128i clamp_max_sse2(__m128i v, __m128i limit) {
+            const __m128i over = _mm_cmpgt_epi32(v, limit);
+            return _mm_or_si128(_mm_and_si128(over, limit), _mm_andnot_si128(over, v));
+        }
+
+        // Two points (x0 y0 x1 y1) to their absolute coordinates in the same lanes
+        __attribute__((target("sse2")))
+        inline __m128i map_pair_sse2(__m128i v, const Factors128 &f) {
+            v = _mm_sub_epi32(v, f.origin);
+            v = _mm_andnot_si128(_mm_cmplt_epi32(v, _mm_setzero_si128()), v);
+            v = clamp_max_sse2(v, _mm_set1_epi32(0xFFFF));
+            const __m128i vy = _mm_srli_epi64(v, 32);
+            const __m128i rx = _mm_add_epi64(_mm_srli_epi64(_mm_mul_epu32(v, f.x_lo), 32), _mm_mul_epu32(v, f.x_hi));
+            const __m128i ry = _mm_add_epi64(_mm_srli_epi64(_mm_mul_epu32(vy, f.y_lo), 32), _mm_mul_epu32(vy, f.y_hi));
+            return clamp_max_sse2(_mm_or_si128(rx, _mm_slli_epi64(ry, 32)),
+                                  _mm_set1_epi32(CoordinateMapper::ABSOLUTE_MAX));
+        }
+
+        __attribute__((target("sse2")))
+        void map_sse2(const CoordinateMapper &mapper, const Point *in, AbsolutePoint *out, size_t n) {
+            const auto &ax = mapper.x_axis();
+            const auto &ay = mapper.y_axis();
+            const Factors128 f = {
+                _mm_setr_epi32(ax.origin, ay.origin, ax.origin, ay.origin),
+                _mm_set1_epi64x(static_cast<uint32_t>(ax.factor)),
+                _mm_set1_epi64x(static_cast<uint32_t>(ax.factor >> 32)),
+                _mm_set1_epi64x(static_cast<uint32_t>(ay.factor)),
+                _mm_set1_epi64x(static_cast<uint32_t>(ay.factor >> 32))
+            };
+
+            size_t i = 0;
+            for (; i + 4 <= n; i += 4) {
+                const __m128i a = map_pair_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i)), f);
+                const __m128i b = map_pair_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i + 2)), f);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_packs_epi32(a, b));
+            }
+            map_scalar(mapper, in + i, out + i, n - i);
+        }
+
+        // Four points to their absolute coordinates in the same lanes
+        __attribute__((target("avx2")))
+        inline __m256i map_quad_avx2(__m256i v, const Factors256 &f) {
+            v = _mm256_sub_epi32(v, f.origin);
+            v = _mm256_min_epi32(_mm256_max_epi32(v, _mm256_setzero_si256()), _mm256_set1_epi32(0xFFFF));
+            const __m256i vy = _mm256_srli_epi64(v, 32);
+            const __m256i rx = _mm256_add_epi64(_mm256_srli_epi64(_mm256_mul_epu32(v, f.x_lo), 32),
+                                                _mm256_mul_epu32(v, f.x_hi));
+            const __m256i ry = _mm256_add_epi64(_mm256_srli_epi64(_mm256_mul_epu32(vy, f.y_lo), 32),
+                                                _mm256_mul_epu32(vy, f.y_hi));
+            return _mm256_min_epi32(_mm256_or_si256(rx, _mm256_slli_epi64(ry, 32)),
+                                    _mm256_set1_epi32(CoordinateMapper::ABSOLUTE_MAX));
+        }
+
+        __attribute__((target("avx2")))
+        void map_avx2(const CoordinateMapper &mapper, const Point *in, AbsolutePoint *out, size_t n) {
+            const auto &ax = mapper.x_axis();
+            const auto &ay = mapper.y_axis();
+            const Factors256 f = {
+                _mm256_setr_epi32(ax.origin, ay.origin, ax.origin, ay.origin,
+                                  ax.origin, ay.origin, ax.origin, ay.origin),
+                _mm256_set1_epi64x(static_cast<uint32_t>(ax.factor)),
+                _mm256_set1_epi64x(static_cast<uint32_t>(ax.factor >> 32)),
+                _mm256_set1_epi64x(static_cast<uint32_t>(ay.factor)),
+                _mm256_set1_epi64x(static_cast<uint32_t>(ay.factor >> 32))
+            };
+
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                const __m256i a = map_quad_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i)), f);
+                const __m256i b = map_quad_avx2(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i + 4)), f);
+                // packs works per 128-bit half: restore point order across the halves
+                const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), packed);
+            }
+            map_sse2(mapper, in + i, out + i, n - i);
+        }
+#endif
+
+        SimdLevel detect() {
+#ifdef CH9329_X86_KERNELS
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+            if (__builtin_cpu_supports("sse2")) return SimdLevel::SSE2;
+#endif
+            return SimdLevel::Scalar;
+        }
+    }
+
+    const char *to_string(SimdLevel level) {
+        switch (level) {
+            case SimdLevel::Scalar: return "scalar";
+            case SimdLevel::SSE2: return "sse2";
+            case SimdLevel::AVX2: return "avx2";
+        }
+        return "unknown";
+    }
+
+    SimdLevel best_simd_level() {
+        static const SimdLevel level = detect();
+        return level;
+    }
+
+    void map_points(const CoordinateMapper &mapper, std::span<const Point> points, std::span<AbsolutePoint> out,
+                    SimdLevel level) {
+        const size_t n = std::min(points.size(), out.size());
+        // The vector kernels cap offsets at 16 bits, which is only lossless for desktops that fit in them
+        if (mapper.width() > 0xFFFF || mapper.height() > 0xFFFF) level = SimdLevel::Scalar;
+        switch (std::min(level, best_simd_level())) {
+#ifdef CH9329_X86_KERNELS
+            case SimdLevel::AVX2: return map_avx2(mapper, points.data(), out.data(), n);
+            case SimdLevel::SSE2: return map_sse2(mapper, points.data(), out.data(), n);
+#endif
+            default: return map_scalar(mapper, points.data(), out.data(), n);
+        }
+    }
+
+    size_t encode_abs_frames(const CoordinateMapper &mapper, std::span<const Point> points, std::span<uint8_t> out,
+                             uint8_t buttons, int8_t wheel, SimdLevel level) {
+        using protocol::Command;
+        const size_t n = std::min(points.size(), out.size() / ABS_FRAME_SIZE);
+
+        // Every frame shares the template; only the coordinate bytes and the checksum change
+        const auto frame = protocol::encode<Command::SendMsAbsData>(protocol::ms_abs_payload(buttons, 0, 0, wheel));
+        const uint8_t base_sum = frame.back();
+
+        std::array<AbsolutePoint, CHUNK> mapped;
+        for (size_t start = 0; start < n; start += CHUNK) {
+            const size_t count = std::min(CHUNK, n - start);
+            map_points(mapper, points.subspan(start, count), mapped, level);
+            for (size_t i = 0; i < count; ++i) {
+                uint8_t *dst = out.data() + (start + i) * ABS_FRAME_SIZE;
+                const auto [x, y] = mapped[i];
+                std::memcpy(dst, frame.data(), ABS_FRAME_SIZE);
+                dst[protocol::HEADER_SIZE + 2] = static_cast<uint8_t>(x);
+                dst[protocol::HEADER_SIZE + 3] = static_cast<uint8_t>(x >> 8);
+                dst[protocol::HEADER_SIZE + 4] = static_cast<uint8_t>(y);
+                dst[protocol::HEADER_SIZE + 5] = static_cast<uint8_t>(y >> 8);
+                dst[ABS_FRAME_SIZE - 1] = static_cast<uint8_t>(base_sum + (x & 0xFF) + (x >> 8) + (y & 0xFF) + (y >> 8));
+            }
+        }
+        return n;
+    }
+}
@@ -0,0 +1,138 @@
+#include <ch9329/BroadcastGroup.hpp>
+#include <algorithm>
+
+namespace ender {
+    namespace {
+        // Valid response without the error flag; one-byte status payloads must also report success
+        bool acknowledged(std::span<const uint8_t> response) {
+            if (response.size() < protocol::FRAME_OVERHEAD) return false;
+            if (response[3] & protocol::RESPONSE_ERROR_FLAG) return false;
+            const auto command = static_cast<protocol::Command>(response[3] & protocol::RESPONSE_CMD_MASK);
+            const auto payload = protocol::validate_frame(response, command);
+            return payload && (payload->size() != 1 || protocol::is_success(payload->first<1>()));
+        }
+    }
+
+    std::chrono::nanoseconds BroadcastGroup::Report::max_skew() const {
+        std::chrono::nanoseconds skew{0};
+        for (const auto &device: devices) skew = std::max(skew, device.skew);
+        return skew;
+    }
+
+    size_t BroadcastGroup::Report::failures() const {
+        return std::count_if(devices.begin(), devices.end(), [](const DeviceResult &device) { return !device.ok; });
+    }
+
+    BroadcastGroup::BroadcastGroup() : BroadcastGroup(Options{}) {
+    }
+
+    BroadcastGroup::BroadcastGroup(const Options &options) : options_(options) {
+    }
+
+    BroadcastGroup::~BroadcastGroup() {
+        {
+            std::lock_guard lock(mutex_);
+            stopping_ = true;
+        }
+        job_ready_.notify_all();
+        for (auto &worker: workers_) worker.join();
+    }
+
+    size_t BroadcastGroup::add(CH9329Controller &controller) {
+        controllers_.push_back(&controller);
+        return controllers_.size() - 1;
+    }
+
+    void BroadcastGroup::start_workers() {
+        size_t count = options_.threads != 0 ? options_.threads : std::max(1u, std::thread::hardware_concurrency());
+        count = std::min(count, controllers_.size());
+        for (size_t i = 0; i < count; ++i) {
+            workers_.emplace_back([this, i, count] { run(i, count); });
+        }
+    }
+
+    BroadcastGroup::Report BroadcastGroup::broadcast(std::span<const uint8_t> frames, size_t frame_count) {
+        return broadcast_at(std::chrono::steady_clock::now() + options_.lead, frames, frame_count);
+    }
+
+    BroadcastGroup::Report BroadcastGroup::broadcast_at(std::chrono::steady_clock::time_point deadline,
+                                                        std::span<const uint8_t> frames, size_t frame_count) {
+        Report report;
+        report.deadline = deadline;
+        report.devices.resize(controllers_.size());
+        if (controllers_.empty()) return report;
+        if (workers_.empty()) start_workers();
+
+        {
+            std::unique_lock lock(mutex_);
+            job_.deadline = deadline;
+            job_.frames = frames;
+            job_.frame_count = frame_count;
+            job_.written.assign(controllers_.size(), {});
+            job_.results = &report.devices;
+            pending_workers_ = workers_.size();
+            ++generation_;
+            job_ready_.notify_all();
+            job_done_.wait(lock, [this] { return pending_workers_ == 0; });
+        }
+
+        const auto earliest = *std::min_element(job_.written.begin(), job_.written.end());
+        for (size_t i = 0; i < controllers_.size(); ++i) {
+            report.devices[i].offset = job_.written[i] - deadline;
+            report.devices[i].skew = job_.written[i] - earliest;
+        }
+        return report;
+    }
+
+    void BroadcastGroup::run(size_t worker, size_t worker_count) {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock lock(mutex_);
+                job_ready_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+                if (stopping_) return;
+                seen = generation_;
+            }
+
+            serve(worker, worker_count);
+
+            std::lock_guard lock(mutex_);
+            if (--pending_workers_ == 0) job_done_.notify_one();
+        }
+    }
+
+    void BroadcastGroup::serve(size_t worker, size_t worker_count) {
+        // Each worker touches only its own devices' slots, so the job needs no locking here
+        const auto deadline = job_.deadline;
+
+        // Take the ports before the deadline so a status poll cannot delay or split the transaction
+        std::vector<PortLock> locks;
+        for (size_t i = worker; i < controllers_.size(); i += worker_count) {
+            locks.push_back(controllers_[i]->lock_port());
+        }
+
+        std::this_thread::sleep_until(deadline - options_.spin);
+        while (std::chrono::steady_clock::now() < deadline) {
+        }
+
+        for (size_t i = worker; i < controllers_.size(); i += worker_count) {
+            (*job_.results)[i].ok = controllers_[i]->write_frames(job_.frames);
+            job_.written[i] = std::chrono::steady_clock::now();
+        }
+
+        for (size_t i = worker; i < controllers_.size(); i += worker_count) {
+            auto &result = (*job_.results)[i];
+            if (!result.ok) continue;
+            bool all_acknowledged = true;
+            result.responses = controllers_[i]->read_responses(
+                job_.frame_count, [&all_acknowledged](size_t, std::span<const uint8_t> response) {
+                    all_acknowledged = all_acknowledged && acknowledged(response);
+                });
+            result.ok = all_acknowledged && result.responses == job_.frame_count;
+            // Late ACKs of a short batch would be read as the next broadcast's responses
+            if (result.responses < job_.frame_count && !controllers_[i]->link_lost()) {
+                controllers_[i]->drain_input();
+            }
+        }
+    }
+}
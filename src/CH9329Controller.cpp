@@ -1,200 +1,469 @@
 #include <ch9329/CH9329Controller.hpp>
 #include <iostream>
 #include <thread>
-#include <numeric>
+#include <algorithm>
 #include <ranges>
 namespace ender {
-    constexpr uint8_t FRAME_HEAD_1 = 0x57;
-    constexpr uint8_t FRAME_HEAD_2 = 0xAB;
-    constexpr uint8_t DEVICE_ADDR = 0x00;
+    using protocol::Command;
+
+    namespace {
+        // Errors that mean the adapter is gone (unplugged or re-enumerated) rather than a bad frame
+        bool is_link_lost(const boost::system::error_code &ec) {
+            return ec == boost::system::errc::io_error ||
+                   ec == boost::system::errc::no_such_device ||
+                   ec == boost::system::errc::no_such_device_or_address ||
+                   ec == boost::system::errc::broken_pipe ||
+                   ec == asio::error::bad_descriptor ||
+                   ec == asio::error::eof;
+        }
+
+        // Allocator that places asio's operation state in a controller-owned block
+        template<typename T, typename Memory>
+        class ArenaAllocator {
+        public:
+            using value_type = T;
+
+            explicit ArenaAllocator(Memory &memory) : memory_(&memory) {
+            }
+
+            template<typename U>
+            ArenaAllocator(const ArenaAllocator<U, Memory> &other) : memory_(other.memory_) {
+            }
+
+            T *allocate(size_t n) { return static_cast<T *>(memory_->allocate(sizeof(T) * n)); }
+
+            void deallocate(T *p, size_t) { memory_->deallocate(p); }
+
+            bool operator==(const ArenaAllocator &) const = default;
+
+        private:
+            template<typename, typename>
+            friend class ArenaAllocator;
+
+            Memory *memory_;
+        };
+
+        template<typename Memory>
+        struct ReadHandler {
+            using allocator_type = ArenaAllocator<void, Memory>;
+
+            boost::system::error_code *ec;
+            std::atomic<bool> *done;
+            Memory *memory;
+
+            allocator_type get_allocator() const noexcept { return allocator_type(*memory); }
+
+            void operator()(const boost::system::error_code &e, size_t) const {
+                *ec = e;
+                done->store(true, std::memory_order_release);
+            }
+        };
+    }
+
+    void *CH9329Controller::HandlerMemory::allocate(size_t size) {
+        if (!in_use && size <= storage.size()) {
+            in_use = true;
+            return storage.data();
+        }
+        return ::operator new(size);
+    }
+
+    void CH9329Controller::HandlerMemory::deallocate(void *p) {
+        if (p == storage.data()) {
+            in_use = false;
+        } else {
+            ::operator delete(p);
+        }
+    }
 
     CH9329Controller::CH9329Controller(const std::string &port, unsigned int baud_rate)
-        : io_(), port_(io_, port) {
-        port_.set_option(asio::serial_port::baud_rate(baud_rate));
+        : owned_io_(std::make_unique<asio::io_context>()), io_(*owned_io_), port_(io_, port),
+          port_path_(port), baud_rate_(baud_rate) {
+        apply_serial_options();
+    }
+
+    CH9329Controller::CH9329Controller(asio::io_context &io, const std::string &port, unsigned int baud_rate)
+        : io_(io), port_(io_, port), port_path_(port), baud_rate_(baud_rate) {
+        apply_serial_options();
+    }
+
+    void CH9329Controller::apply_serial_options() {
+        port_.set_option(asio::serial_port::baud_rate(baud_rate_));
         port_.set_option(asio::serial_port::character_size(8));
         port_.set_option(asio::serial_port::stop_bits(asio::serial_port::stop_bits::one));
         port_.set_option(asio::serial_port::parity(asio::serial_port::parity::none));
         port_.set_option(asio::serial_port::flow_control(asio::serial_port::flow_control::none));
     }
 
+    bool CH9329Controller::reconnect() {
+        std::lock_guard lock(port_mutex_);
+        return reopen();
+    }
+
+    bool CH9329Controller::reopen() {
+        boost::system::error_code ec;
+        if (port_.is_open()) {
+            port_.close(ec);
+        }
+
+        auto backoff = reconnect_policy_.initial_backoff;
+        for (unsigned int attempt = 0; attempt < reconnect_policy_.max_attempts; ++attempt) {
+            std::this_thread::sleep_for(backoff);
+            backoff = std::min(backoff * 2, reconnect_policy_.max_backoff);
+
+            for (const auto &path: {reconnect_policy_.stable_path, port_path_}) {
+                if (path.empty()) continue;
+                port_.open(path, ec);
+                if (ec) continue;
+                try {
+                    apply_serial_options();
+                } catch (const boost::system::system_error &) {
+                    port_.close(ec);
+                    continue;
+                }
+                last_error_.clear();
+                return true;
+            }
+        }
+        return false;
+    }
+
     CH9329Controller::~CH9329Controller() {
         if (port_.is_open()) {
             port_.close();
         }
     }
 
-    std::vector<uint8_t> CH9329Controller::make_frame(uint8_t addr, uint8_t cmd, const std::vector<uint8_t> &data) {
-        std::vector<uint8_t> frame = {FRAME_HEAD_1, FRAME_HEAD_2, addr, cmd, static_cast<uint8_t>(data.size())};
-        frame.insert(frame.end(), data.begin(), data.end());
+    bool CH9329Controller::read_exact(std::span<uint8_t> dst, boost::system::error_code &ec) {
+        return read_exact(dst, ec, timeout_);
+    }
 
-        uint8_t sum = std::accumulate(frame.begin(), frame.end(), 0);
-        frame.push_back(sum);
+    bool CH9329Controller::read_exact(std::span<uint8_t> dst, boost::system::error_code &ec,
+                                      std::chrono::steady_clock::duration timeout) {
+        // Wait for this read's own completion: on a shared io_context other handlers keep the context
+        // from stopping, and may run here while we wait
+        std::atomic<bool> done{false};
+        auto finished = [&done] { return done.load(std::memory_order_acquire); };
+        asio::async_read(port_, asio::buffer(dst.data(), dst.size()),
+                         ReadHandler<HandlerMemory>{&ec, &done, &read_handler_memory_});
 
-        return frame;
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!finished() && std::chrono::steady_clock::now() < deadline) {
+            if (io_.stopped()) io_.restart();
+            io_.run_one_until(deadline);
+        }
+        if (!finished()) {
+            // Deadline reached with the read still pending: cancel it and run until its handler has been called
+            boost::system::error_code ignored;
+            port_.cancel(ignored);
+            while (!finished()) {
+                if (io_.stopped()) io_.restart();
+                io_.run_one_for(std::chrono::milliseconds(10));
+            }
+            // The read may still have completed just before the cancel
+            if (ec == asio::error::operation_aborted) ec = asio::error::timed_out;
+        }
+        return !ec;
     }
 
-    std::optional<std::vector<uint8_t> > CH9329Controller::read_response() {
-        boost::system::error_code ec;
-        std::vector<uint8_t> buffer(128);
-        size_t len = port_.read_some(asio::buffer(buffer), ec);
-        if (ec || len < 6) return std::nullopt;
+    std::optional<std::span<const uint8_t> > CH9329Controller::read_response(RxBuffer &rx,
+                                                                             boost::system::error_code &ec,
+                                                                             size_t have) {
+        if (!read_exact(std::span(rx).subspan(have, protocol::HEADER_SIZE - have), ec)) return std::nullopt;
 
-        buffer.resize(len);
-        return buffer;
+        // Drop stray bytes ahead of the frame head instead of failing every later response
+        while (rx[0] != protocol::FRAME_HEAD_1 || rx[1] != protocol::FRAME_HEAD_2) {
+            std::copy(rx.begin() + 1, rx.begin() + protocol::HEADER_SIZE, rx.begin());
+            if (!read_exact(std::span(rx).subspan(protocol::HEADER_SIZE - 1, 1), ec)) return std::nullopt;
+        }
+
+        const size_t len = rx[4];
+        if (len > protocol::MAX_PAYLOAD) return std::nullopt;
+        if (!read_exact(std::span(rx).subspan(protocol::HEADER_SIZE, len + 1), ec)) return std::nullopt;
+
+        return std::span<const uint8_t>(rx.data(), protocol::FRAME_OVERHEAD + len);
     }
 
-    std::optional<std::vector<uint8_t> > CH9329Controller::validate_response(
-        const std::vector<uint8_t> &resp, uint8_t expected_cmd) {
-        if (resp.size() < 6) return std::nullopt;
-        if (resp[0] != FRAME_HEAD_1 || resp[1] != FRAME_HEAD_2) return std::nullopt;
-        if (resp[2] != DEVICE_ADDR) return std::nullopt;
+    std::optional<std::span<const uint8_t> > CH9329Controller::send_command(std::span<const uint8_t> frame) {
+        auto response = transact(frame, rx_buffer_, last_error_);
+        if (response || !is_link_lost(last_error_) || !reconnect_policy_.enabled) {
+            mark_activity();
+            return response;
+        }
 
-        uint8_t rcv_cmd = resp[3];
-        if ((rcv_cmd & 0x3F) != expected_cmd) return std::nullopt;
+        // The adapter went away mid-command: reopen it, then retry or fail the pending command by policy
+        if (!reopen()) return std::nullopt;
+        if (reconnect_policy_.pending == PendingCommandPolicy::Fail) return std::nullopt;
+        response = transact(frame, rx_buffer_, last_error_);
+        mark_activity();
+        return response;
+    }
 
-        uint8_t len = resp[4];
-        if (resp.size() != 6 + len) return std::nullopt;
+    std::optional<std::span<const uint8_t> > CH9329Controller::transact(std::span<const uint8_t> frame, RxBuffer &rx,
+                                                                        boost::system::error_code &ec) {
+        if (!port_.is_open()) {
+            ec = asio::error::bad_descriptor;
+            return std::nullopt;
+        }
 
-        uint8_t sum = std::accumulate(resp.begin(), resp.end() - 1, 0);
-        if (resp.back() != sum) return std::nullopt;
+        asio::write(port_, asio::buffer(frame.data(), frame.size()), ec);
+        if (ec) return std::nullopt;
 
-        return std::vector<uint8_t>(resp.begin() + 5, resp.end() - 1);
+        return read_reply(rx, ec);
     }
 
-    std::optional<std::vector<uint8_t> > CH9329Controller::send_command(uint8_t cmd, const std::vector<uint8_t> &data) {
-        auto frame = make_frame(DEVICE_ADDR, cmd, data);
+    std::optional<std::span<const uint8_t> > CH9329Controller::read_reply(RxBuffer &rx, boost::system::error_code &ec) {
+        while (true) {
+            const auto frame = read_response(rx, ec);
+            if (!frame || !divert_hid_input(*frame)) return frame;
+        }
+    }
+
+    bool CH9329Controller::divert_hid_input(std::span<const uint8_t> frame) {
+        if (!hid_input_handler_ || frame[3] != (static_cast<uint8_t>(Command::ReadMyHidData) | 0x80)) return false;
+        const auto payload = protocol::decode<Command::ReadMyHidData>(frame);
+        if (payload) hid_input_handler_(*payload);
+        return true;
+    }
+
+    bool CH9329Controller::link_lost() const {
+        return is_link_lost(last_error_);
+    }
+
+    void CH9329Controller::mark_activity() {
+        last_activity_.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    }
+
+    size_t CH9329Controller::send_frames(std::span<const uint8_t> batch, size_t frame_count,
+                                         const ResponseHandler &on_response) {
+        std::lock_guard lock(port_mutex_);
+        const size_t answered = write_frames(batch) ? read_responses(frame_count, on_response) : 0;
+        if (answered < frame_count && port_.is_open() && !is_link_lost(last_error_)) drain_input();
+        mark_activity();
+        return answered;
+    }
+
+    bool CH9329Controller::write_frames(std::span<const uint8_t> batch) {
+        if (port_.is_open()) {
+            asio::write(port_, asio::buffer(batch.data(), batch.size()), last_error_);
+        } else {
+            last_error_ = asio::error::bad_descriptor;
+        }
+        if (last_error_ && is_link_lost(last_error_) && reconnect_policy_.enabled) {
+            reopen();
+            return false;
+        }
+        return !last_error_;
+    }
+
+    size_t CH9329Controller::drain_input(std::chrono::microseconds quiet) {
+        size_t discarded = 0;
         boost::system::error_code ec;
-        asio::write(port_, asio::buffer(frame), ec);
-        if (ec) return std::nullopt;
+        while (port_.is_open() && read_exact(std::span(rx_buffer_).first(1), ec, quiet)) {
+            const auto frame = read_response(rx_buffer_, ec, 1);
+            if (!frame) break;
+            if (!divert_hid_input(*frame)) ++discarded;
+        }
+        return discarded;
+    }
 
-        std::this_thread::sleep_for(10ms);
+    size_t CH9329Controller::drain_input() {
+        const auto frame_time = std::chrono::microseconds(protocol::MAX_FRAME_SIZE * 10 * 1000000ull /
+                                                          std::max(baud_rate_, 1u));
+        return drain_input(frame_time + std::chrono::milliseconds(10));
+    }
 
-        auto resp = read_response();
-        if (!resp) return std::nullopt;
+    size_t CH9329Controller::read_responses(size_t frame_count, const ResponseHandler &on_response) {
+        size_t answered = 0;
+        for (; answered < frame_count; ++answered) {
+            const auto response = read_reply(rx_buffer_, last_error_);
+            if (!response) break;
+            on_response(answered, *response);
+        }
 
-        auto payload = validate_response(*resp, cmd);
-        if (!payload || payload->empty()) return std::nullopt;
+        // Unanswered requests are left to the caller: the device may already have executed some of them
+        if (answered < frame_count && is_link_lost(last_error_) && reconnect_policy_.enabled) {
+            reopen();
+        }
+        return answered;
+    }
 
-        return payload;
+    template<protocol::Command C>
+    bool CH9329Controller::send_status_command(std::span<const uint8_t> frame) {
+        std::lock_guard lock(port_mutex_);
+        const auto response = send_command(frame);
+        if (!response) return false;
+        const auto status = protocol::decode<C>(*response);
+        return status.has_value() && protocol::is_success(*status);
+    }
+
+    template<protocol::Command C>
+    std::optional<protocol::response_t<C> > CH9329Controller::send_query(std::span<const uint8_t> frame) {
+        std::lock_guard lock(port_mutex_);
+        const auto response = send_command(frame);
+        if (!response) return std::nullopt;
+        return protocol::decode_as<C>(*response);
     }
 
     std::optional<DeviceInfo> CH9329Controller::get_info() {
-        const auto response = send_command(0x01);
-        if (!response || response->size() < 8) return std::nullopt;
-        DeviceInfo info{};
+        return send_query<Command::GetInfo>(protocol::frames::get_info);
+    }
 
-        const uint8_t version = (*response)[0];
-        info.version_major = (version >> 4) & 0x0F - 2;
-        info.version_minor = version & 0x0F;
+    std::optional<DeviceInfo> CH9329Controller::poll_info() {
+        // Side-channel buffers: the caller may still be decoding a response from rx_buffer_
+        const auto response = transact(protocol::frames::get_info, status_rx_buffer_, status_error_);
+        if (!response) return std::nullopt;
+        return protocol::decode_as<Command::GetInfo>(*response);
+    }
 
-        info.usb_connected = (*response)[1] == 0x01;
+    bool CH9329Controller::send_ms_rel_data(MouseButton button, int8_t x_delta, int8_t y_delta, int8_t wheel) {
+        const auto frame = protocol::encode<Command::SendMsRelData>(
+            protocol::ms_rel_payload(pack_mouse_button(button), x_delta, y_delta, wheel));
+        return send_status_command<Command::SendMsRelData>(frame);
+    }
 
-        const uint8_t led_status = (*response)[2];
-        info.num_lock = (led_status & 0x01) != 0;
-        info.caps_lock = (led_status & 0x02) != 0;
-        info.scroll_lock = (led_status & 0x04) != 0;
+    bool CH9329Controller::presses_new_key(const std::array<uint8_t, 6> &keys) const {
+        return std::ranges::any_of(keys, [this](uint8_t k) {
+            return k != 0 && std::ranges::find(last_kb_keys_, k) == last_kb_keys_.end();
+        });
+    }
 
-        info.pc_sleeping = (*response)[3] == 0x03;
+    std::chrono::steady_clock::time_point CH9329Controller::keystroke_due(const std::array<uint8_t, 6> &keys) const {
+        return presses_new_key(keys) ? next_keystroke_ : std::chrono::steady_clock::time_point::min();
+    }
 
-        return info;
+    void CH9329Controller::record_kb_report(const std::array<uint8_t, 6> &keys,
+                                            std::chrono::steady_clock::time_point sent_at) {
+        // Count from the slot, not the ACK, so round trips do not lower the rate below the one set
+        if (presses_new_key(keys)) next_keystroke_ = std::max(next_keystroke_, sent_at) + keystroke_interval_;
+        last_kb_keys_ = keys;
     }
 
-    bool CH9329Controller::send_ms_rel_data(MouseButton button, int8_t x_delta, int8_t y_delta, int8_t wheel) {
-        std::vector<uint8_t> data = {
-            0x01, // Report ID for relative mouse
-            pack_mouse_button(button), // Mouse button state
-            static_cast<uint8_t>(x_delta), // X movement delta
-            static_cast<uint8_t>(y_delta), // Y movement delta
-            static_cast<uint8_t>(wheel) // Wheel movement
-        };
-        const auto r = send_command(0x05, data);
-        return r.has_value() &&
-               !r->empty() &&
-               r->at(0) == static_cast<uint8_t>(CommandStatus::Success);
+    bool CH9329Controller::send_kb_report(KeyboardCtrlKey ctrl, const std::array<uint8_t, 6> &keys) {
+        const auto sent_at = std::chrono::steady_clock::now();
+        std::optional<std::span<const uint8_t> > response;
+        // Single key without modifiers (or a full release) is the common case: use the pre-encoded frame
+        if (pack_keyboard_ctrl_key(ctrl) == 0 &&
+            std::all_of(keys.begin() + 1, keys.end(), [](uint8_t k) { return k == 0; })) {
+            response = send_command(protocol::frames::kb_single_key[keys[0]]);
+        } else {
+            const auto frame = protocol::encode<Command::SendKbGeneralData>(
+                protocol::kb_general_payload(pack_keyboard_ctrl_key(ctrl), keys));
+            response = send_command(frame);
+        }
+
+        const auto status = response ? protocol::decode<Command::SendKbGeneralData>(*response) : std::nullopt;
+        const bool ok = status.has_value() && protocol::is_success(*status);
+        if (ok) record_kb_report(keys, sent_at);
+        return ok;
     }
 
     bool CH9329Controller::send_kb_general_data(KeyboardCtrlKey ctrl, const std::array<uint8_t, 6> &keys) {
-        std::vector<uint8_t> data(8, 0);
-        data[0] = pack_keyboard_ctrl_key(ctrl);
-        data[1] = 0x00;
-        std::ranges::copy(keys, data.begin() + 2);
-        const auto r = send_command(0x02, data);
-        return r.has_value() && !r->empty() && r->at(0) == static_cast<uint8_t>(CommandStatus::Success);
+        // Wait for the pacing slot without the port, then check again: another sender may have taken it
+        PortLock lock(port_mutex_);
+        for (auto due = keystroke_due(keys); due > std::chrono::steady_clock::now(); due = keystroke_due(keys)) {
+            lock.unlock();
+            std::this_thread::sleep_until(due);
+            lock.lock();
+        }
+        return send_kb_report(ctrl, keys);
+    }
+
+    std::optional<bool> CH9329Controller::try_send_kb_general_data(KeyboardCtrlKey ctrl,
+                                                                   const std::array<uint8_t, 6> &keys) {
+        std::lock_guard lock(port_mutex_);
+        if (keystroke_due(keys) > std::chrono::steady_clock::now()) return std::nullopt;
+        return send_kb_report(ctrl, keys);
+    }
+
+    std::chrono::steady_clock::time_point CH9329Controller::keystroke_ready_at(const std::array<uint8_t, 6> &keys) {
+        std::lock_guard lock(port_mutex_);
+        return keystroke_due(keys);
+    }
+
+    bool CH9329Controller::type_keys(std::span<const uint8_t> keys, KeyboardCtrlKey ctrl) {
+        for (const uint8_t key: keys) {
+            if (!send_kb_general_data(ctrl, {key})) return false;
+            if (!send_kb_general_data(ctrl, {})) return false;
+        }
+        return true;
+    }
+
+    void CH9329Controller::set_keystroke_rate(double keys_per_second) {
+        const double rate = std::max(keys_per_second, 0.0);
+        std::lock_guard lock(port_mutex_);
+        keystroke_rate_.store(rate, std::memory_order_relaxed);
+        keystroke_interval_ = rate > 0
+                                  ? std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                      std::chrono::duration<double>(1.0 / rate))
+                                  : std::chrono::steady_clock::duration(0);
     }
 
     bool CH9329Controller::send_ms_abs_data(MouseButton button, uint16_t x, uint16_t y, int8_t wheel) {
-        std::vector<uint8_t> data(7);
-        data[0] = 0x02;
-        data[1] = pack_mouse_button(button);
-        data[2] = static_cast<uint8_t>(x & 0xFF);
-        data[3] = static_cast<uint8_t>((x >> 8) & 0xFF);
-        data[4] = static_cast<uint8_t>(y & 0xFF);
-        data[5] = static_cast<uint8_t>((y >> 8) & 0xFF);
-        data[6] = static_cast<uint8_t>(wheel);
-        const auto r = send_command(0x04, data);
-        return r.has_value() && !r->empty() && r->at(0) == static_cast<uint8_t>(CommandStatus::Success);
+        const auto frame = protocol::encode<Command::SendMsAbsData>(
+            protocol::ms_abs_payload(pack_mouse_button(button), x, y, wheel));
+        return send_status_command<Command::SendMsAbsData>(frame);
+    }
+
+    std::optional<std::span<const uint8_t> > CH9329Controller::read_frame(std::chrono::microseconds wait) {
+        // Only the wait for a frame to start is bounded by the caller; once it starts it is read like a response
+        if (!port_.is_open()) {
+            last_error_ = asio::error::bad_descriptor;
+            return std::nullopt;
+        }
+        if (!read_exact(std::span(rx_buffer_).first(1), last_error_, wait)) return std::nullopt;
+        const auto frame = read_response(rx_buffer_, last_error_, 1);
+        if (frame && divert_hid_input(*frame)) return std::nullopt;
+        return frame;
     }
 
     std::optional<std::vector<uint8_t> > CH9329Controller::read_hid_data() {
-        return read_response();
+        std::lock_guard lock(port_mutex_);
+        const auto frame = read_response(rx_buffer_, last_error_);
+        if (!frame) return std::nullopt;
+        return std::vector<uint8_t>(frame->begin(), frame->end());
     }
 
     std::optional<UsbStringDescriptor> CH9329Controller::get_usb_string(UsbStringType type) {
-        auto resp = send_command(0x0A, {static_cast<uint8_t>(type)});
-        if (!resp) return std::nullopt;
-
-        UsbStringDescriptor desc;
-        desc.content = std::string(resp->begin(), resp->end());
-        return desc;
+        return send_query<Command::GetUsbString>(
+            protocol::encode<Command::GetUsbString>({static_cast<uint8_t>(type)}));
     }
 
     bool CH9329Controller::set_usb_string(UsbStringType type, const std::string &str) {
-        std::vector<uint8_t> data = {
-            static_cast<uint8_t>(type),
-            static_cast<uint8_t>(str.size())
-        };
-        data.insert(data.end(), str.begin(), str.end());
-        const auto r = send_command(0x0B, data);
-        return r.has_value() && !r->empty() && r->at(0) == static_cast<uint8_t>(CommandStatus::Success);
+        std::array<uint8_t, protocol::describe(Command::SetUsbString).max_request_len> data{};
+        if (str.size() > data.size() - 2) return false;
+        data[0] = static_cast<uint8_t>(type);
+        data[1] = static_cast<uint8_t>(str.size());
+        std::ranges::copy(str, data.begin() + 2);
+        const auto frame = protocol::encode<Command::SetUsbString>(std::span<const uint8_t>(data.data(), 2 + str.size()));
+        return frame && send_status_command<Command::SetUsbString>(frame->view());
     }
 
 
     bool CH9329Controller::send_kb_media_data(uint8_t report_id, uint16_t keycode) {
-        std::vector<uint8_t> data = {
-            report_id, static_cast<uint8_t>(keycode & 0xFF), static_cast<uint8_t>((keycode >> 8) & 0xFF)
-        };
-        const auto r = send_command(0x03, data);
-        return r.has_value() && !r->empty() && r->at(0) == 0x00;
+        const auto frame = protocol::encode<Command::SendKbMediaData>(protocol::kb_media_payload(report_id, keycode));
+        return send_status_command<Command::SendKbMediaData>(frame);
     }
 
     bool CH9329Controller::send_hid_data(const std::vector<uint8_t> &data) {
-        if (data.size() > 64) return false;
-        const auto r = send_command(0x06, data);
-        return r.has_value() && !r->empty() && r->at(0) == 0x00;
+        const auto frame = protocol::encode<Command::SendMyHidData>(data);
+        return frame && send_status_command<Command::SendMyHidData>(frame->view());
     }
 
     std::optional<ParaConfig> CH9329Controller::get_para_config() {
-        auto resp = send_command(0x08);
-        if (!resp || resp->size() != 50) return std::nullopt;
-
-        ParaConfig config{};
-        std::ranges::copy(*resp, config.raw_bytes.begin());
-        return config;
+        return send_query<Command::GetParaCfg>(protocol::frames::get_para_config);
     }
 
     bool CH9329Controller::set_para_config(const ParaConfig &config) {
-        const auto r = send_command(0x09, std::vector<uint8_t>(config.raw_bytes.begin(), config.raw_bytes.end()));
-        return r.has_value() && !r->empty() && r->at(0) == 0x00;
+        return send_status_command<Command::SetParaCfg>(protocol::encode<Command::SetParaCfg>(config.raw_bytes));
     }
 
     bool CH9329Controller::set_default_config() {
-        const auto r = send_command(0x0C);
-        return r.has_value() && !r->empty() && r->at(0) == 0x00;
+        return send_status_command<Command::SetDefaultCfg>(protocol::frames::set_default_config);
     }
 
     bool CH9329Controller::reset() {
-        const auto r = send_command(0x0F);
-        return r.has_value() && !r->empty() && r->at(0) == 0x00;
+        return send_status_command<Command::Reset>(protocol::frames::reset);
     }
 
     bool CH9329Controller::click(MouseButton button, uint16_t hold_time_ms) {
@@ -210,15 +479,15 @@ namespace ender {
     }
 
     bool CH9329Controller::mouse_down(MouseButton button) {
-        std::vector<uint8_t> data = {0x01, pack_mouse_button(button), 0x00, 0x00, 0x00};
-        auto r = send_command(0x05, data);
-        return r.has_value() && !r->empty() && r->at(0) == static_cast<uint8_t>(CommandStatus::Success);
+        const uint8_t mask = pack_mouse_button(button);
+        if (mask < protocol::frames::ms_buttons.size()) {
+            return send_status_command<Command::SendMsRelData>(protocol::frames::ms_buttons[mask]);
+        }
+        return send_ms_rel_data(button, 0, 0, 0);
     }
 
     bool CH9329Controller::mouse_up(MouseButton button) {
-        std::vector<uint8_t> data = {0x01, 0x00, 0x00, 0x00, 0x00}; // Release all buttons
-        auto r = send_command(0x05, data);
-        return r.has_value() && !r->empty() && r->at(0) == static_cast<uint8_t>(CommandStatus::Success);
+        return send_status_command<Command::SendMsRelData>(protocol::frames::ms_release); // Release all buttons
     }
 
     bool CH9329Controller::drag(MouseButton button, int8_t x_delta, int8_t y_delta, uint16_t hold_time_ms) {
@@ -230,37 +499,17 @@ namespace ender {
     }
 
     bool CH9329Controller::move_mouse(int8_t x_delta, int8_t y_delta) {
-        std::vector<uint8_t> data = {
-            0x01, 0x00,
-            static_cast<uint8_t>(x_delta),
-            static_cast<uint8_t>(y_delta),
-            0x00
-        };
-        auto r = send_command(0x05, data);
-        return r.has_value() && !r->empty() && r->at(0) == static_cast<uint8_t>(CommandStatus::Success);
+        return send_ms_rel_data(MouseButton::None, x_delta, y_delta, 0);
     }
 
     bool CH9329Controller::scroll_wheel(int8_t wheel_delta) {
-        std::vector<uint8_t> data = {0x01, 0x00, 0x00, 0x00, static_cast<uint8_t>(wheel_delta)};
-        auto r = send_command(0x05, data);
-        return r.has_value() && !r->empty() && r->at(0) == static_cast<uint8_t>(CommandStatus::Success);
+        return send_ms_rel_data(MouseButton::None, 0, 0, wheel_delta);
     }
 
     bool CH9329Controller::move_to_absolute(uint16_t x, uint16_t y) {
         x = std::min(x, static_cast<uint16_t>(4095));
         y = std::min(y, static_cast<uint16_t>(4095));
-
-        std::vector<uint8_t> data(7);
-        data[0] = 0x02; // Absolute mouse report ID
-        data[1] = 0x00; // No buttons pressed
-        data[2] = static_cast<uint8_t>(x & 0xFF);
-        data[3] = static_cast<uint8_t>((x >> 8) & 0xFF);
-        data[4] = static_cast<uint8_t>(y & 0xFF);
-        data[5] = static_cast<uint8_t>((y >> 8) & 0xFF);
-        data[6] = 0x00; // No wheel movement
-
-        auto r = send_command(0x04, data);
-        return r.has_value() && !r->empty() && r->at(0) == static_cast<uint8_t>(CommandStatus::Success);
+        return send_ms_abs_data(MouseButton::None, x, y, 0);
     }
 
     bool CH9329Controller::click_at_absolute(uint16_t x, uint16_t y, MouseButton button, uint16_t hold_time_ms) {
@@ -281,9 +530,7 @@ namespace ender {
     }
 
     bool CH9329Controller::hover(uint16_t duration_ms) {
-        std::vector<uint8_t> data = {0x01, 0x00, 0x00, 0x00, 0x00};
-        auto r = send_command(0x05, data);
-        if (!(r.has_value() && !r->empty() && r->at(0) == static_cast<uint8_t>(CommandStatus::Success))) {
+        if (!send_status_command<Command::SendMsRelData>(protocol::frames::ms_release)) {
             return false;
         }
         std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
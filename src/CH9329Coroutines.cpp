@@ -0,0 +1,278 @@
+#include <ch9329/CH9329Controller.hpp>
+
+namespace ender {
+    using protocol::Command;
+
+    namespace {
+        constexpr auto use_task = asio::use_awaitable;
+
+        // Completion handler of a parked co_lock() or co_lock_port(); resuming posts it to the executor it belongs to
+        template<typename Handler, typename Base>
+        struct CoWaiterOf final : Base {
+            Handler handler;
+
+            explicit CoWaiterOf(Handler h) : handler(std::move(h)) {
+            }
+
+            void resume() override {
+                const auto executor = asio::get_associated_executor(handler);
+                asio::post(executor, std::move(handler));
+            }
+        };
+
+        // A co_read_exact() in flight; the read and timer handlers both run on the port's strand
+        template<typename Handler>
+        struct StrandRead {
+            Handler handler;
+            asio::steady_timer timer;
+            bool done = false;
+            bool expired = false;
+
+            StrandRead(Handler h, const asio::strand<asio::io_context::executor_type> &strand,
+                       std::chrono::steady_clock::time_point deadline)
+                : handler(std::move(h)), timer(strand, deadline) {
+            }
+        };
+    }
+
+    task<void> CH9329Controller::co_lock() {
+        {
+            std::lock_guard lock(co_mutex_);
+            if (!co_busy_) {
+                co_busy_ = true;
+                co_return;
+            }
+        }
+        // The initiation runs once this coroutine has suspended, so a hand-over from another thread cannot
+        // arrive before the handler is parked. Check again: the owner may have let go in between
+        co_await asio::async_initiate<decltype(use_task), void()>(
+            [this](auto handler) {
+                std::unique_lock lock(co_mutex_);
+                if (!co_busy_) {
+                    co_busy_ = true;
+                    lock.unlock();
+                    CoWaiterOf<decltype(handler), CoWaiter>(std::move(handler)).resume();
+                    return;
+                }
+                co_waiters_.push_back(std::make_unique<CoWaiterOf<decltype(handler), CoWaiter> >(std::move(handler)));
+            }, use_task);
+    }
+
+    void CH9329Controller::co_unlock() {
+        std::unique_ptr<CoWaiter> next;
+        {
+            std::lock_guard lock(co_mutex_);
+            if (co_waiters_.empty()) {
+                co_busy_ = false;
+                return;
+            }
+            next = std::move(co_waiters_.front());
+            co_waiters_.pop_front();
+        }
+        next->resume();
+    }
+
+    task<void> CH9329Controller::delay(std::chrono::milliseconds duration) {
+        asio::steady_timer timer(io_, duration);
+        boost::system::error_code ec;
+        co_await timer.async_wait(asio::redirect_error(use_task, ec));
+    }
+
+    task<void> CH9329Controller::co_lock_port() {
+        if (port_mutex_.try_lock()) co_return;
+        co_await asio::async_initiate<decltype(use_task), void()>(
+            [this](auto handler) {
+                std::unique_ptr<PortMutex::Waiter> waiter =
+                        std::make_unique<CoWaiterOf<decltype(handler), PortMutex::Waiter> >(std::move(handler));
+                if (port_mutex_.lock_or_park(waiter)) waiter->resume();
+            }, use_task);
+    }
+
+    task<void> CH9329Controller::co_read_exact(std::span<uint8_t> dst, std::chrono::steady_clock::time_point deadline,
+                                               boost::system::error_code &ec) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            ec = asio::error::timed_out;
+            co_return;
+        }
+        auto token = asio::redirect_error(use_task, ec);
+        co_await asio::async_initiate<decltype(token), void(boost::system::error_code)>(
+            [this, dst, deadline](auto handler) {
+                auto op = std::make_shared<StrandRead<decltype(handler)> >(std::move(handler), port_strand_, deadline);
+                asio::dispatch(port_strand_, [this, dst, op] {
+                    op->timer.async_wait([this, op](const boost::system::error_code &e) {
+                        // Already queued when the read finished: the port may now belong to the next read
+                        if (e || op->done) return;
+                        op->expired = true;
+                        boost::system::error_code ignored;
+                        port_.cancel(ignored);
+                    });
+                    asio::async_read(port_, asio::buffer(dst.data(), dst.size()), asio::bind_executor(
+                                         port_strand_, [op](boost::system::error_code e, size_t) {
+                                             op->done = true;
+                                             op->timer.cancel();
+                                             if (op->expired && e == asio::error::operation_aborted) {
+                                                 e = asio::error::timed_out;
+                                             }
+                                             const auto executor = asio::get_associated_executor(op->handler);
+                                             asio::post(executor, [handler = std::move(op->handler), e]() mutable {
+                                                 handler(e);
+                                             });
+                                         }));
+                });
+            }, token);
+    }
+
+    task<CH9329Controller::CoPortGuard> CH9329Controller::co_lock_all() {
+        CoPortGuard guard;
+        co_await co_lock();
+        guard.co_.reset(this);
+        co_await co_lock_port();
+        guard.port_ = PortLock(port_mutex_, std::adopt_lock);
+        co_return guard;
+    }
+
+    task<std::optional<protocol::Frame> > CH9329Controller::co_send_command(std::span<const uint8_t> frame) {
+        const auto guard = co_await co_lock_all();
+        co_return co_await co_transact(frame);
+    }
+
+    task<std::optional<protocol::Frame> > CH9329Controller::co_transact(std::span<const uint8_t> frame) {
+        std::optional<protocol::Frame> response;
+        boost::system::error_code ec;
+        co_await asio::async_write(port_, asio::buffer(frame.data(), frame.size()),
+                                   asio::redirect_error(use_task, ec));
+
+        // One deadline for the whole response, enforced on every read
+        const auto deadline = std::chrono::steady_clock::now() + timeout_;
+        protocol::Frame rx;
+        while (!ec && !response) {
+            co_await co_read_exact(std::span(rx.bytes).first(protocol::HEADER_SIZE), deadline, ec);
+            while (!ec && (rx.bytes[0] != protocol::FRAME_HEAD_1 || rx.bytes[1] != protocol::FRAME_HEAD_2)) {
+                std::copy(rx.bytes.begin() + 1, rx.bytes.begin() + protocol::HEADER_SIZE, rx.bytes.begin());
+                co_await co_read_exact(std::span(rx.bytes).subspan(protocol::HEADER_SIZE - 1, 1), deadline, ec);
+            }
+            const size_t len = rx.bytes[4];
+            if (ec || len > protocol::MAX_PAYLOAD) break;
+            co_await co_read_exact(std::span(rx.bytes).subspan(protocol::HEADER_SIZE, len + 1), deadline, ec);
+            if (ec) break;
+            rx.size = protocol::FRAME_OVERHEAD + len;
+            // Host HID input arriving ahead of the response goes to its handler; keep reading
+            if (!divert_hid_input(rx.view())) response = rx;
+        }
+        last_error_ = ec;
+        co_return response;
+    }
+
+    template<protocol::Command C>
+    task<bool> CH9329Controller::co_send_status_command(std::span<const uint8_t> frame) {
+        const auto response = co_await co_send_command(frame);
+        if (!response) co_return false;
+        const auto status = protocol::decode<C>(response->view());
+        co_return status.has_value() && protocol::is_success(*status);
+    }
+
+    task<std::optional<DeviceInfo> > CH9329Controller::co_get_info() {
+        const auto response = co_await co_send_command(protocol::frames::get_info);
+        if (!response) co_return std::nullopt;
+        co_return protocol::decode_as<Command::GetInfo>(response->view());
+    }
+
+    task<std::optional<UsbStringDescriptor> > CH9329Controller::co_get_usb_string(UsbStringType type) {
+        const auto request = protocol::encode<Command::GetUsbString>({static_cast<uint8_t>(type)});
+        const auto response = co_await co_send_command(request);
+        if (!response) co_return std::nullopt;
+        co_return protocol::decode_as<Command::GetUsbString>(response->view());
+    }
+
+    task<bool> CH9329Controller::co_send_kb_general_data(KeyboardCtrlKey ctrl, const std::array<uint8_t, 6> &keys) {
+        const auto frame = protocol::encode<Command::SendKbGeneralData>(
+            protocol::kb_general_payload(pack_keyboard_ctrl_key(ctrl), keys));
+
+        // Paced like send_kb_general_data(): wait for the slot on a timer with the port released
+        auto guard = co_await co_lock_all();
+        for (auto due = keystroke_due(keys); due > std::chrono::steady_clock::now(); due = keystroke_due(keys)) {
+            guard.unlock();
+            asio::steady_timer timer(io_, due);
+            boost::system::error_code ec;
+            co_await timer.async_wait(asio::redirect_error(use_task, ec));
+            guard = co_await co_lock_all();
+        }
+
+        const auto sent_at = std::chrono::steady_clock::now();
+        const auto response = co_await co_transact(frame);
+        const auto status = response ? protocol::decode<Command::SendKbGeneralData>(response->view()) : std::nullopt;
+        const bool ok = status.has_value() && protocol::is_success(*status);
+        if (ok) record_kb_report(keys, sent_at);
+        co_return ok;
+    }
+
+    task<bool> CH9329Controller::co_send_ms_abs_data(MouseButton button, uint16_t x, uint16_t y, int8_t wheel) {
+        const auto frame = protocol::encode<Command::SendMsAbsData>(
+            protocol::ms_abs_payload(pack_mouse_button(button), x, y, wheel));
+        co_return co_await co_send_status_command<Command::SendMsAbsData>(frame);
+    }
+
+    task<bool> CH9329Controller::co_send_ms_rel_data(MouseButton button, int8_t x_delta, int8_t y_delta,
+                                                     int8_t wheel) {
+        const auto frame = protocol::encode<Command::SendMsRelData>(
+            protocol::ms_rel_payload(pack_mouse_button(button), x_delta, y_delta, wheel));
+        co_return co_await co_send_status_command<Command::SendMsRelData>(frame);
+    }
+
+    task<bool> CH9329Controller::co_mouse_down(MouseButton button) {
+        const uint8_t mask = pack_mouse_button(button);
+        if (mask < protocol::frames::ms_buttons.size()) {
+            co_return co_await co_send_status_command<Command::SendMsRelData>(protocol::frames::ms_buttons[mask]);
+        }
+        co_return co_await co_send_ms_rel_data(button, 0, 0, 0);
+    }
+
+    task<bool> CH9329Controller::co_mouse_up(MouseButton) {
+        co_return co_await co_send_status_command<Command::SendMsRelData>(protocol::frames::ms_release);
+    }
+
+    task<bool> CH9329Controller::co_move_mouse(int8_t x_delta, int8_t y_delta) {
+        co_return co_await co_send_ms_rel_data(MouseButton::None, x_delta, y_delta, 0);
+    }
+
+    task<bool> CH9329Controller::co_move_to_absolute(uint16_t x, uint16_t y) {
+        x = std::min(x, static_cast<uint16_t>(4095));
+        y = std::min(y, static_cast<uint16_t>(4095));
+        co_return co_await co_send_ms_abs_data(MouseButton::None, x, y, 0);
+    }
+
+    task<bool> CH9329Controller::co_click(MouseButton button, uint16_t hold_time_ms) {
+        if (const bool ok = co_await co_mouse_down(button); !ok) co_return false;
+        co_await delay(std::chrono::milliseconds(hold_time_ms));
+        co_return co_await co_mouse_up(button);
+    }
+
+    task<bool> CH9329Controller::co_double_click(MouseButton button, uint16_t click_interval_ms,
+                                                 uint16_t hold_time_ms) {
+        if (const bool ok = co_await co_click(button, hold_time_ms); !ok) co_return false;
+        co_await delay(std::chrono::milliseconds(click_interval_ms));
+        co_return co_await co_click(button, hold_time_ms);
+    }
+
+    task<bool> CH9329Controller::co_click_at_absolute(uint16_t x, uint16_t y, MouseButton button,
+                                                      uint16_t hold_time_ms) {
+        if (const bool ok = co_await co_move_to_absolute(x, y); !ok) co_return false;
+        co_await delay(std::chrono::milliseconds(10));
+        co_return co_await co_click(button, hold_time_ms);
+    }
+
+    task<bool> CH9329Controller::co_drag_absolute(uint16_t start_x, uint16_t start_y,
+                                                  uint16_t end_x, uint16_t end_y,
+                                                  MouseButton button) {
+        if (const bool ok = co_await co_move_to_absolute(start_x, start_y); !ok) co_return false;
+        if (const bool ok = co_await co_mouse_down(button); !ok) co_return false;
+        co_await delay(std::chrono::milliseconds(50));
+        if (const bool ok = co_await co_move_to_absolute(end_x, end_y); !ok) co_return false;
+        co_await delay(std::chrono::milliseconds(50));
+        co_return co_await co_mouse_up(button);
+    }
+
+    task<bool> CH9329Controller::co_drag_select(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2) {
+        co_return co_await co_drag_absolute(x1, y1, x2, y2, MouseButton::Left);
+    }
+}
@@ -0,0 +1,84 @@
+#include <ch9329/CoordinateMapper.hpp>
+#include <ch9329/BatchConvert.hpp>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace ender {
+    namespace {
+        // ceil(numerator * 2^32 / extent): exact floor division for offset * extent < 2^32
+        uint64_t fixed_factor(double numerator, uint32_t extent) {
+            return static_cast<uint64_t>(std::ceil(numerator * 4294967296.0 / extent));
+        }
+    }
+
+    CoordinateMapper::CoordinateMapper(uint32_t width, uint32_t height)
+        : monitors_{Monitor{0, 0, width, height, 1.0}} {
+        build();
+    }
+
+    CoordinateMapper::CoordinateMapper(std::span<const Monitor> monitors)
+        : monitors_(monitors.begin(), monitors.end()) {
+        build();
+    }
+
+    void CoordinateMapper::build() {
+        if (monitors_.empty()) throw std::invalid_argument("CoordinateMapper needs at least one monitor");
+
+        int64_t left = std::numeric_limits<int64_t>::max();
+        int64_t top = std::numeric_limits<int64_t>::max();
+        int64_t right = std::numeric_limits<int64_t>::min();
+        int64_t bottom = std::numeric_limits<int64_t>::min();
+        for (const auto &m: monitors_) {
+            if (m.width == 0 || m.height == 0 || !(m.scale > 0)) {
+                throw std::invalid_argument("CoordinateMapper monitor has no area");
+            }
+            left = std::min<int64_t>(left, m.x);
+            top = std::min<int64_t>(top, m.y);
+            right = std::max<int64_t>(right, m.x + static_cast<int64_t>(m.width));
+            bottom = std::max<int64_t>(bottom, m.y + static_cast<int64_t>(m.height));
+        }
+
+        x_ = {static_cast<int32_t>(left), fixed_factor(ABSOLUTE_MAX, static_cast<uint32_t>(right - left))};
+        y_ = {static_cast<int32_t>(top), fixed_factor(ABSOLUTE_MAX, static_cast<uint32_t>(bottom - top))};
+        width_ = static_cast<uint32_t>(right - left);
+        height_ = static_cast<uint32_t>(bottom - top);
+
+        local_.clear();
+        for (const auto &m: monitors_) {
+            local_.push_back({
+                static_cast<uint64_t>(m.x - left) * x_.factor,
+                static_cast<uint64_t>(m.y - top) * y_.factor,
+                fixed_factor(m.scale * ABSOLUTE_MAX, width_),
+                fixed_factor(m.scale * ABSOLUTE_MAX, height_)
+            });
+        }
+    }
+
+    void CoordinateMapper::map(std::span<const Point> points, std::span<AbsolutePoint> out) const {
+        map_points(*this, points, out);
+    }
+
+    std::vector<AbsolutePoint> CoordinateMapper::map(std::span<const Point> points) const {
+        std::vector<AbsolutePoint> out(points.size());
+        map(points, out);
+        return out;
+    }
+
+    void CoordinateMapper::map(size_t monitor, std::span<const Point> points, std::span<AbsolutePoint> out) const {
+        const size_t n = std::min(points.size(), out.size());
+        for (size_t i = 0; i < n; ++i) out[i] = map(monitor, points[i]);
+    }
+
+    std::optional<size_t> CoordinateMapper::monitor_at(Point p) const {
+        for (size_t i = 0; i < monitors_.size(); ++i) {
+            const auto &m = monitors_[i];
+            if (p.x >= m.x && p.y >= m.y &&
+                static_cast<int64_t>(p.x) < m.x + static_cast<int64_t>(m.width) &&
+                static_cast<int64_t>(p.y) < m.y + static_cast<int64_t>(m.height)) {
+                return i;
+            }
+        }
+        return std::nullopt;
+    }
+}
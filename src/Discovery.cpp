@@ -0,0 +1,84 @@
+#include <ch9329/Discovery.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <algorithm>
+#include <glob.h>
+
+namespace ender {
+    namespace {
+        struct Probe {
+            std::string path;
+            std::optional<DiscoveredDevice> device;
+            std::string serial;
+        };
+
+        task<void> probe(asio::io_context &io, const DiscoveryOptions &options, Probe &result) {
+            for (const unsigned int baud_rate: options.baud_rates) {
+                std::unique_ptr<CH9329Controller> controller;
+                try {
+                    controller = std::make_unique<CH9329Controller>(io, result.path, baud_rate);
+                } catch (const boost::system::system_error &) {
+                    co_return;
+                }
+                controller->set_timeout(options.timeout);
+
+                const auto info = co_await controller->co_get_info();
+                if (!info) continue;
+                const auto serial = co_await controller->co_get_usb_string(UsbStringType::SerialNumber);
+                if (!serial) continue;
+
+                result.device = DiscoveredDevice{result.path, baud_rate, *info};
+                result.serial = serial->content;
+                co_return;
+            }
+        }
+    }
+
+    std::map<std::string, std::string> DiscoveryResult::paths() const {
+        std::map<std::string, std::string> paths;
+        for (const auto &[serial, device]: devices) paths.emplace(serial, device.path);
+        return paths;
+    }
+
+    std::vector<std::string> candidate_ports(const std::vector<std::string> &patterns) {
+        std::vector<std::string> ports;
+        for (const auto &pattern: patterns) {
+            glob_t matches{};
+            if (::glob(pattern.c_str(), 0, nullptr, &matches) == 0) {
+                ports.insert(ports.end(), matches.gl_pathv, matches.gl_pathv + matches.gl_pathc);
+            }
+            ::globfree(&matches);
+        }
+        std::ranges::sort(ports);
+        ports.erase(std::unique(ports.begin(), ports.end()), ports.end());
+        return ports;
+    }
+
+    DiscoveryResult discover(const DiscoveryOptions &options) {
+        auto ports = candidate_ports(options.patterns);
+        ports.insert(ports.end(), options.ports.begin(), options.ports.end());
+        std::ranges::sort(ports);
+        ports.erase(std::unique(ports.begin(), ports.end()), ports.end());
+
+        std::vector<Probe> probes(ports.size());
+        {
+            asio::io_context io;
+            for (size_t i = 0; i < ports.size(); ++i) {
+                probes[i].path = ports[i];
+                asio::co_spawn(io, probe(io, options, probes[i]), asio::detached);
+            }
+            io.run();
+        }
+
+        // Probes are in path order, so the first claim of a serial number is the lowest path
+        DiscoveryResult result;
+        for (auto &p: probes) {
+            if (!p.device) {
+                result.silent.push_back(p.path);
+            } else if (!result.devices.emplace(p.serial, std::move(*p.device)).second) {
+                result.duplicates.push_back(p.path);
+            }
+        }
+        return result;
+    }
+}
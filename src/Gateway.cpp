@@ -0,0 +1,486 @@
+#include <ch9329/Gateway.hpp>
+#include <ch9329/ShmRing.hpp>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace ender {
+    namespace {
+        using Strand = asio::strand<asio::io_context::executor_type>;
+        using SessionSocket = asio::basic_stream_socket<asio::generic::stream_protocol, Strand>;
+        using Acceptor = asio::basic_socket_acceptor<asio::generic::stream_protocol>;
+
+        constexpr auto ACCEPT_RETRY_DELAY = std::chrono::milliseconds(100);
+
+        /*
+         * @brief Reply bytes ready to be written to a client
+         */
+        struct EncodedReply {
+            std::array<uint8_t, GATEWAY_REPLY_HEADER_SIZE + protocol::MAX_PAYLOAD> bytes{};
+            size_t size = GATEWAY_REPLY_HEADER_SIZE;
+        };
+
+        EncodedReply make_reply(uint8_t status, std::span<const uint8_t> payload = {}) {
+            EncodedReply reply;
+            reply.bytes[0] = status;
+            reply.bytes[1] = static_cast<uint8_t>(payload.size());
+            std::ranges::copy(payload, reply.bytes.begin() + GATEWAY_REPLY_HEADER_SIZE);
+            reply.size = GATEWAY_REPLY_HEADER_SIZE + payload.size();
+            return reply;
+        }
+
+        EncodedReply make_reply(GatewayStatus status) {
+            return make_reply(static_cast<uint8_t>(status));
+        }
+
+        // Status-only responses and device errors reply with the status byte; data responses with the payload
+        EncodedReply reply_from_response(const protocol::CommandDescriptor &d, std::span<const uint8_t> response) {
+            const auto payload = protocol::validate_frame(response, d.code);
+            if (!payload || payload->empty()) return make_reply(GatewayStatus::DeviceUnavailable);
+            if ((response[3] & protocol::RESPONSE_ERROR_FLAG) != 0 || d.response_len == 1) {
+                return make_reply((*payload)[0]);
+            }
+            return make_reply(static_cast<uint8_t>(CommandStatus::Success), *payload);
+        }
+
+        struct Request {
+            uint64_t seq = 0;
+            const protocol::CommandDescriptor *descriptor = nullptr;
+            protocol::Frame frame;
+        };
+    }
+
+    struct Gateway::State {
+        Options options;
+        std::vector<std::shared_ptr<Device> > devices;
+        std::vector<std::shared_ptr<Listener> > listeners;
+        std::vector<std::unique_ptr<Ring> > rings;
+
+        std::mutex sessions_mutex;
+        std::vector<std::weak_ptr<Session> > sessions;
+
+        std::atomic<bool> stopped{false};
+        std::atomic<uint64_t> requests{0};
+        std::atomic<uint64_t> batches{0};
+        std::atomic<uint64_t> failures{0};
+        std::atomic<uint64_t> connections{0};
+        std::atomic<uint64_t> ring_records{0};
+    };
+
+    struct Gateway::Listener {
+        Acceptor acceptor;
+        std::string unix_path;
+        asio::steady_timer retry; // Delays the next accept after a failed one (e.g. EMFILE)
+    };
+
+    /*
+     * @brief Requests of one connection for one device
+     */
+    struct Gateway::Lane {
+        std::weak_ptr<Session> session;
+        std::deque<Request> queue;
+        bool scheduled = false; // Present in the device's ready list
+        bool detached = false; // Fed by a shared-memory ring: no session, no replies
+    };
+
+    struct Gateway::Device {
+        std::unique_ptr<CH9329Controller> controller;
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<std::shared_ptr<Lane> > ready; // Lanes with queued requests, in round-robin order
+        bool stopping = false;
+        std::thread worker;
+
+        void submit(const std::shared_ptr<Lane> &lane, Request request) {
+            {
+                std::lock_guard lock(mutex);
+                lane->queue.push_back(std::move(request));
+                if (!lane->scheduled) {
+                    lane->scheduled = true;
+                    ready.push_back(lane);
+                }
+            }
+            cv.notify_one();
+        }
+
+        size_t queued(const Lane &lane) {
+            std::lock_guard lock(mutex);
+            return lane.queue.size();
+        }
+
+        void run(State &state);
+    };
+
+    struct Gateway::Ring {
+        std::unique_ptr<ShmRingConsumer> consumer;
+        std::shared_ptr<Lane> lane;
+        std::shared_ptr<Device> device;
+        std::thread thread;
+
+        void run(State &state) {
+            while (!state.stopped.load(std::memory_order_relaxed)) {
+                if (!consumer->wait(std::chrono::milliseconds(100))) continue;
+                const size_t queued = device->queued(*lane);
+                if (queued >= state.options.max_in_flight) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+                    continue;
+                }
+                const size_t drained = consumer->drain([this](ShmRecordType type, std::span<const uint8_t> payload) {
+                    const auto cmd = command_for(type);
+                    const auto *descriptor = cmd ? &protocol::describe(*cmd) : nullptr;
+                    auto frame = descriptor ? protocol::encode_frame(*descriptor, payload) : std::nullopt;
+                    if (frame) device->submit(lane, {0, descriptor, *frame});
+                }, state.options.max_in_flight - queued);
+                state.ring_records.fetch_add(drained, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    struct Gateway::Session : std::enable_shared_from_this<Session> {
+        SessionSocket socket;
+        std::shared_ptr<State> state;
+        std::vector<std::shared_ptr<Lane> > lanes; // Indexed by device
+
+        std::array<uint8_t, GATEWAY_REQUEST_HEADER_SIZE + protocol::MAX_PAYLOAD> in{};
+        uint64_t next_seq = 0;
+        uint64_t next_write = 0;
+        std::map<uint64_t, EncodedReply> done; // Replies waiting for earlier ones to complete
+        std::vector<uint8_t> out;
+        std::vector<uint8_t> writing_buf;
+        bool writing = false;
+        bool read_paused = false;
+        bool closed = false;
+
+        Session(SessionSocket s, std::shared_ptr<State> st) : socket(std::move(s)), state(std::move(st)) {
+        }
+
+        void start() {
+            boost::system::error_code ignored;
+            socket.set_option(asio::ip::tcp::no_delay(true), ignored); // Fails harmlessly on Unix sockets
+            for (size_t i = 0; i < state->devices.size(); ++i) {
+                auto lane = std::make_shared<Lane>();
+                lane->session = weak_from_this();
+                lanes.push_back(std::move(lane));
+            }
+            read_header();
+        }
+
+        void read_header() {
+            asio::async_read(socket, asio::buffer(in.data(), GATEWAY_REQUEST_HEADER_SIZE),
+                             [self = shared_from_this()](const boost::system::error_code &ec, size_t) {
+                                 if (ec) return self->close();
+                                 self->read_payload();
+                             });
+        }
+
+        void read_payload() {
+            const size_t len = in[2];
+            if (len > protocol::MAX_PAYLOAD) return close(); // Cannot be a valid request; framing is lost
+            if (len == 0) return dispatch();
+            asio::async_read(socket, asio::buffer(in.data() + GATEWAY_REQUEST_HEADER_SIZE, len),
+                             [self = shared_from_this()](const boost::system::error_code &ec, size_t) {
+                                 if (ec) return self->close();
+                                 self->dispatch();
+                             });
+        }
+
+        void dispatch() {
+            const uint64_t seq = next_seq++;
+            const uint8_t device = in[0];
+            const auto payload = std::span<const uint8_t>(in.data() + GATEWAY_REQUEST_HEADER_SIZE, in[2]);
+            state->requests.fetch_add(1, std::memory_order_relaxed);
+
+            if (device >= lanes.size()) {
+                complete(seq, make_reply(GatewayStatus::UnknownDevice));
+            } else {
+                // READ_MY_HID_DATA only ever travels from the device to the controller
+                const auto *descriptor = protocol::find_descriptor(in[1]);
+                if (descriptor && descriptor->code == protocol::Command::ReadMyHidData) descriptor = nullptr;
+                auto frame = descriptor ? protocol::encode_frame(*descriptor, payload) : std::nullopt;
+                if (!frame) {
+                    complete(seq, make_reply(GatewayStatus::BadRequest));
+                } else {
+                    state->devices[device]->submit(lanes[device], {seq, descriptor, *frame});
+                }
+            }
+
+            if (next_seq - next_write >= state->options.max_in_flight) {
+                read_paused = true;
+            } else {
+                read_header();
+            }
+        }
+
+        // Runs on the session strand
+        void complete(uint64_t seq, const EncodedReply &reply) {
+            if (closed) return;
+            done.emplace(seq, reply);
+            while (!done.empty() && done.begin()->first == next_write) {
+                const auto &r = done.begin()->second;
+                out.insert(out.end(), r.bytes.begin(), r.bytes.begin() + static_cast<std::ptrdiff_t>(r.size));
+                done.erase(done.begin());
+                ++next_write;
+            }
+            flush();
+            if (read_paused && next_seq - next_write < state->options.max_in_flight) {
+                read_paused = false;
+                read_header();
+            }
+        }
+
+        void flush() {
+            if (writing || out.empty() || closed) return;
+            writing = true;
+            std::swap(out, writing_buf);
+            asio::async_write(socket, asio::buffer(writing_buf),
+                              [self = shared_from_this()](const boost::system::error_code &ec, size_t) {
+                                  self->writing = false;
+                                  self->writing_buf.clear();
+                                  if (ec) return self->close();
+                                  self->flush();
+                              });
+        }
+
+        void close() {
+            if (closed) return;
+            closed = true;
+            boost::system::error_code ignored;
+            socket.close(ignored);
+        }
+    };
+
+    void Gateway::Device::run(State &state) {
+        std::vector<std::pair<std::shared_ptr<Lane>, Request> > batch;
+        std::vector<EncodedReply> replies;
+        std::vector<uint8_t> wire;
+
+        for (;;) {
+            {
+                std::unique_lock lock(mutex);
+                cv.wait(lock, [this] { return stopping || !ready.empty(); });
+                if (stopping) return;
+
+                // One request per connection per turn keeps a busy client from starving the others
+                batch.clear();
+                while (batch.size() < state.options.max_batch && !ready.empty()) {
+                    auto lane = std::move(ready.front());
+                    ready.pop_front();
+                    batch.emplace_back(lane, std::move(lane->queue.front()));
+                    lane->queue.pop_front();
+                    if (lane->queue.empty()) {
+                        lane->scheduled = false;
+                    } else {
+                        ready.push_back(std::move(lane));
+                    }
+                }
+            }
+
+            std::erase_if(batch, [](const auto &entry) {
+                return !entry.first->detached && entry.first->session.expired();
+            });
+            if (batch.empty()) continue;
+
+            wire.clear();
+            for (const auto &[lane, request]: batch) {
+                const auto frame = request.frame.view();
+                wire.insert(wire.end(), frame.begin(), frame.end());
+            }
+            replies.assign(batch.size(), make_reply(GatewayStatus::DeviceUnavailable));
+            const size_t answered = controller->send_frames(wire, batch.size(),
+                                                            [&](size_t i, std::span<const uint8_t> response) {
+                                                                replies[i] = reply_from_response(
+                                                                    *batch[i].second.descriptor, response);
+                                                            });
+            state.batches.fetch_add(1, std::memory_order_relaxed);
+            state.failures.fetch_add(batch.size() - answered, std::memory_order_relaxed);
+
+            for (size_t i = 0; i < batch.size(); ++i) {
+                auto session = batch[i].first->session.lock();
+                if (!session) continue;
+                asio::post(session->socket.get_executor(),
+                           [session, seq = batch[i].second.seq, reply = replies[i]] {
+                               session->complete(seq, reply);
+                           });
+            }
+        }
+    }
+
+    Gateway::Gateway(asio::io_context &io)
+        : Gateway(io, Options{}) {
+    }
+
+    Gateway::Gateway(asio::io_context &io, const Options &options)
+        : io_(io), state_(std::make_shared<State>()) {
+        state_->options = options;
+        state_->options.max_batch = std::max<size_t>(options.max_batch, 1);
+        state_->options.max_in_flight = std::max<size_t>(options.max_in_flight, 1);
+    }
+
+    Gateway::~Gateway() {
+        stop();
+    }
+
+    uint8_t Gateway::add_device(const std::string &port, unsigned int baud_rate) {
+        if (state_->devices.size() > std::numeric_limits<uint8_t>::max()) {
+            throw std::length_error("gateway supports at most 256 devices");
+        }
+        auto device = std::make_shared<Device>();
+        device->controller = std::make_unique<CH9329Controller>(port, baud_rate);
+        device->worker = std::thread([d = device.get(), s = state_.get()] { d->run(*s); });
+        state_->devices.push_back(std::move(device));
+        return static_cast<uint8_t>(state_->devices.size() - 1);
+    }
+
+    uint16_t Gateway::listen_tcp(const asio::ip::tcp::endpoint &endpoint) {
+        auto listener = std::make_shared<Listener>(
+            Listener{Acceptor(io_, asio::generic::stream_protocol::endpoint(endpoint)), {}, asio::steady_timer(io_)});
+        const auto local = listener->acceptor.local_endpoint();
+        asio::ip::tcp::endpoint bound;
+        std::memcpy(bound.data(), local.data(), local.size());
+        bound.resize(local.size());
+
+        state_->listeners.push_back(listener);
+        accept(io_, state_, listener);
+        return bound.port();
+    }
+
+    void Gateway::listen_unix(const std::string &path) {
+        std::remove(path.c_str());
+        auto listener = std::make_shared<Listener>(
+            Listener{Acceptor(io_, asio::generic::stream_protocol::endpoint(asio::local::stream_protocol::endpoint(path))), path,
+                     asio::steady_timer(io_)});
+        state_->listeners.push_back(listener);
+        accept(io_, state_, listener);
+    }
+
+    void Gateway::attach_ring(const std::string &name, uint8_t device, size_t capacity) {
+        if (device >= state_->devices.size()) throw std::out_of_range("attach_ring: unknown device");
+        auto ring = std::make_unique<Ring>();
+        ring->consumer = std::make_unique<ShmRingConsumer>(name, capacity);
+        ring->lane = std::make_shared<Lane>();
+        ring->lane->detached = true;
+        ring->device = state_->devices[device];
+        ring->thread = std::thread([r = ring.get(), s = state_.get()] { r->run(*s); });
+        state_->rings.push_back(std::move(ring));
+    }
+
+    void Gateway::accept(asio::io_context &io, const std::shared_ptr<State> &state,
+                         const std::shared_ptr<Listener> &listener) {
+        listener->acceptor.async_accept(
+            asio::make_strand(io),
+            [&io, state, listener](const boost::system::error_code &ec, SessionSocket socket) {
+                if (state->stopped.load()) return;
+                if (!ec) {
+                    auto session = std::make_shared<Session>(std::move(socket), state);
+                    {
+                        std::lock_guard lock(state->sessions_mutex);
+                        std::erase_if(state->sessions, [](const auto &s) { return s.expired(); });
+                        state->sessions.push_back(session);
+                    }
+                    state->connections.fetch_add(1, std::memory_order_relaxed);
+                    session->start();
+                } else if (ec == asio::error::operation_aborted) {
+                    return;
+                } else {
+                    // Out of descriptors or memory: retrying at once would spin until the condition clears
+                    listener->retry.expires_after(ACCEPT_RETRY_DELAY);
+                    listener->retry.async_wait([&io, state, listener](const boost::system::error_code &e) {
+                        if (!e && !state->stopped.load()) accept(io, state, listener);
+                    });
+                    return;
+                }
+                accept(io, state, listener);
+            });
+    }
+
+    void Gateway::stop() {
+        if (state_->stopped.exchange(true)) return;
+
+        for (const auto &listener: state_->listeners) {
+            asio::post(io_, [listener] {
+                boost::system::error_code ignored;
+                listener->acceptor.close(ignored);
+                listener->retry.cancel();
+            });
+            if (!listener->unix_path.empty()) std::remove(listener->unix_path.c_str());
+        }
+        {
+            std::lock_guard lock(state_->sessions_mutex);
+            for (const auto &weak: state_->sessions) {
+                if (auto session = weak.lock()) {
+                    asio::post(session->socket.get_executor(), [session] { session->close(); });
+                }
+            }
+        }
+        for (const auto &ring: state_->rings) {
+            ring->consumer->notify();
+            if (ring->thread.joinable()) ring->thread.join();
+        }
+        for (const auto &device: state_->devices) {
+            {
+                std::lock_guard lock(device->mutex);
+                device->stopping = true;
+            }
+            device->cv.notify_all();
+            if (device->worker.joinable()) device->worker.join();
+        }
+    }
+
+    Gateway::Stats Gateway::stats() const {
+        return {
+            state_->requests.load(std::memory_order_relaxed),
+            state_->batches.load(std::memory_order_relaxed),
+            state_->failures.load(std::memory_order_relaxed),
+            state_->connections.load(std::memory_order_relaxed),
+            state_->ring_records.load(std::memory_order_relaxed)
+        };
+    }
+
+    GatewayClient::GatewayClient(const asio::ip::tcp::endpoint &endpoint)
+        : io_(), socket_(io_) {
+        socket_.connect(asio::generic::stream_protocol::endpoint(endpoint));
+        socket_.set_option(asio::ip::tcp::no_delay(true));
+    }
+
+    GatewayClient::GatewayClient(const std::string &unix_path)
+        : io_(), socket_(io_) {
+        socket_.connect(asio::generic::stream_protocol::endpoint(asio::local::stream_protocol::endpoint(unix_path)));
+    }
+
+    bool GatewayClient::send(uint8_t device, protocol::Command cmd, std::span<const uint8_t> payload) {
+        if (payload.size() > protocol::MAX_PAYLOAD) return false;
+        std::array<uint8_t, GATEWAY_REQUEST_HEADER_SIZE + protocol::MAX_PAYLOAD> buf{};
+        buf[0] = device;
+        buf[1] = static_cast<uint8_t>(cmd);
+        buf[2] = static_cast<uint8_t>(payload.size());
+        std::ranges::copy(payload, buf.begin() + GATEWAY_REQUEST_HEADER_SIZE);
+        boost::system::error_code ec;
+        asio::write(socket_, asio::buffer(buf.data(), GATEWAY_REQUEST_HEADER_SIZE + payload.size()), ec);
+        return !ec;
+    }
+
+    std::optional<GatewayClient::Reply> GatewayClient::receive() {
+        Reply reply;
+        std::array<uint8_t, GATEWAY_REPLY_HEADER_SIZE> header{};
+        boost::system::error_code ec;
+        asio::read(socket_, asio::buffer(header), ec);
+        if (ec || header[1] > protocol::MAX_PAYLOAD) return std::nullopt;
+        reply.status = header[0];
+        reply.size = header[1];
+        asio::read(socket_, asio::buffer(reply.data.data(), reply.size), ec);
+        if (ec) return std::nullopt;
+        return reply;
+    }
+
+    std::optional<GatewayClient::Reply> GatewayClient::call(uint8_t device, protocol::Command cmd,
+                                                           std::span<const uint8_t> payload) {
+        if (!send(device, cmd, payload)) return std::nullopt;
+        return receive();
+    }
+}
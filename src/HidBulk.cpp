@@ -0,0 +1,94 @@
+#include <ch9329/HidBulk.hpp>
+#include <deque>
+
+namespace ender {
+    using protocol::Command;
+
+    size_t HidBulkResult::failed() const {
+        return static_cast<size_t>(std::ranges::count(packets, false, &HidPacketStatus::acknowledged));
+    }
+
+    double HidBulkResult::bytes_per_second() const {
+        return elapsed.count() > 0 ? static_cast<double>(bytes) * 1e6 / static_cast<double>(elapsed.count()) : 0.0;
+    }
+
+    HidBulkResult send_hid_bulk(CH9329Controller &controller, std::span<const uint8_t> data,
+                                const HidBulkOptions &options) {
+        HidBulkResult result;
+        const size_t count = (data.size() + protocol::MAX_PAYLOAD - 1) / protocol::MAX_PAYLOAD;
+        result.packets.resize(count);
+        // Cap the window so a full window and its ACKs cross the link within half the command timeout;
+        // otherwise the oldest ACK times out behind its own queue and the window is resent needlessly
+        const auto frame_time = std::chrono::microseconds(
+            (protocol::MAX_FRAME_SIZE + protocol::FRAME_OVERHEAD + 1) * 10 * 1000000 / controller.baud_rate());
+        const auto link_window = static_cast<size_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(controller.timeout()).count() / 2 / frame_time.count());
+        const size_t window = std::clamp<size_t>(options.window, 1, std::max<size_t>(link_window, 1));
+        const unsigned int max_attempts = std::max(options.max_attempts, 1u);
+
+        auto packet = [&data](size_t index) {
+            const size_t offset = index * protocol::MAX_PAYLOAD;
+            return data.subspan(offset, std::min(protocol::MAX_PAYLOAD, data.size() - offset));
+        };
+
+        std::deque<size_t> pending;
+        for (size_t i = 0; i < count; ++i) pending.push_back(i);
+        std::deque<size_t> in_flight; // Oldest first: the device answers in request order
+        std::vector<uint8_t> batch;
+        batch.reserve(window * protocol::MAX_FRAME_SIZE);
+
+        // A failed send goes back in the queue while it has attempts left
+        auto retry = [&](size_t index) {
+            if (result.packets[index].attempts < max_attempts) {
+                pending.push_back(index);
+                ++result.retransmits;
+            }
+        };
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto lock = controller.lock_port();
+        while (!pending.empty() || !in_flight.empty()) {
+            // Top the window up in one write
+            batch.clear();
+            while (in_flight.size() < window && !pending.empty()) {
+                const size_t index = pending.front();
+                pending.pop_front();
+                const auto frame = protocol::encode<Command::SendMyHidData>(packet(index));
+                batch.insert(batch.end(), frame->bytes.begin(), frame->bytes.begin() + frame->size);
+                ++result.packets[index].attempts;
+                in_flight.push_back(index);
+            }
+            if (!batch.empty() && !controller.write_frames(batch)) {
+                // Nothing written reliably: the whole window goes round again
+                for (const size_t index: in_flight) retry(index);
+                in_flight.clear();
+                continue;
+            }
+
+            bool acknowledged = false;
+            const size_t answered = controller.read_responses(1, [&acknowledged](size_t, std::span<const uint8_t> response) {
+                const auto status = protocol::decode<Command::SendMyHidData>(response);
+                acknowledged = status && protocol::is_success(*status);
+            });
+            if (answered == 0) {
+                // Timeout: the device dropped the window (or its answers), resend everything in flight.
+                // Drain first, or late ACKs of the old window would be credited to the resent packets
+                if (!controller.link_lost()) controller.drain_input();
+                for (const size_t index: in_flight) retry(index);
+                in_flight.clear();
+                continue;
+            }
+
+            const size_t index = in_flight.front();
+            in_flight.pop_front();
+            if (acknowledged) {
+                result.packets[index].acknowledged = true;
+                result.bytes += packet(index).size();
+            } else {
+                retry(index);
+            }
+        }
+        result.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        return result;
+    }
+}
@@ -0,0 +1,119 @@
+#include <ch9329/HidInput.hpp>
+#include <algorithm>
+#include <numeric>
+
+namespace ender {
+    HidBufferPool::Buffer &HidBufferPool::Buffer::operator=(Buffer &&other) noexcept {
+        if (this != &other) {
+            release();
+            pool_ = std::exchange(other.pool_, nullptr);
+            slot_ = other.slot_;
+            size_ = other.size_;
+        }
+        return *this;
+    }
+
+    std::span<const uint8_t> HidBufferPool::Buffer::data() const {
+        if (!pool_) return {};
+        return {pool_->storage_.data() + static_cast<size_t>(slot_) * protocol::MAX_PAYLOAD, size_};
+    }
+
+    void HidBufferPool::Buffer::release() {
+        if (pool_) std::exchange(pool_, nullptr)->release(slot_);
+    }
+
+    HidBufferPool::HidBufferPool(size_t slots)
+        : storage_(std::max<size_t>(slots, 1) * protocol::MAX_PAYLOAD), free_(std::max<size_t>(slots, 1)) {
+        // Lowest slots on top of the stack, so a lightly used pool stays in a few cache lines
+        std::iota(free_.rbegin(), free_.rend(), 0u);
+    }
+
+    HidBufferPool::Buffer HidBufferPool::acquire(std::span<const uint8_t> payload) {
+        if (payload.size() > protocol::MAX_PAYLOAD) return {};
+        uint32_t slot;
+        {
+            std::lock_guard lock(mutex_);
+            if (free_.empty()) return {};
+            slot = free_.back();
+            free_.pop_back();
+        }
+        std::ranges::copy(payload, storage_.begin() + static_cast<std::ptrdiff_t>(slot) * protocol::MAX_PAYLOAD);
+        return {this, slot, payload.size()};
+    }
+
+    size_t HidBufferPool::available() const {
+        std::lock_guard lock(mutex_);
+        return free_.size();
+    }
+
+    void HidBufferPool::release(uint32_t slot) {
+        std::lock_guard lock(mutex_);
+        free_.push_back(slot); // Within the capacity reserved at construction
+    }
+
+    HidInputStream::HidInputStream(CH9329Controller &controller, Handler handler)
+        : HidInputStream(controller, std::move(handler), Options{}) {
+    }
+
+    HidInputStream::HidInputStream(CH9329Controller &controller, Handler handler, const Options &options)
+        : controller_(controller), handler_(std::move(handler)), options_(options), pool_(options.buffers) {
+        // A command in flight on another thread may be calling the handler: swap it with the port held
+        const auto port = controller_.lock_port();
+        controller_.set_hid_input_handler([this](std::span<const uint8_t> payload) { deliver(payload); });
+    }
+
+    HidInputStream::~HidInputStream() {
+        stop();
+        const auto port = controller_.lock_port();
+        controller_.set_hid_input_handler({});
+    }
+
+    void HidInputStream::start() {
+        if (running_.exchange(true)) return;
+        thread_ = std::thread([this] { run(); });
+    }
+
+    void HidInputStream::stop() {
+        running_.store(false);
+        if (thread_.joinable()) thread_.join();
+    }
+
+    HidInputStream::Stats HidInputStream::stats() const {
+        return {
+            packets_.load(std::memory_order_relaxed),
+            bytes_.load(std::memory_order_relaxed),
+            dropped_.load(std::memory_order_relaxed)
+        };
+    }
+
+    void HidInputStream::deliver(std::span<const uint8_t> payload) {
+        auto buffer = pool_.acquire(payload);
+        if (!buffer) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        packets_.fetch_add(1, std::memory_order_relaxed);
+        bytes_.fetch_add(payload.size(), std::memory_order_relaxed);
+        handler_(std::move(buffer));
+    }
+
+    void HidInputStream::run() {
+        while (running_.load(std::memory_order_relaxed)) {
+            // Only read while no command is in flight; commands deliver host data they come across themselves
+            auto port = controller_.try_lock_port();
+            if (!port.owns_lock()) {
+                std::this_thread::sleep_for(options_.idle_wait);
+                continue;
+            }
+            // Host data reaches deliver() through the input handler; anything else here is a stray frame
+            const auto before = packets_.load(std::memory_order_relaxed) + dropped_.load(std::memory_order_relaxed);
+            controller_.read_frame(options_.idle_wait);
+            if (packets_.load(std::memory_order_relaxed) + dropped_.load(std::memory_order_relaxed) != before) continue;
+
+            // Nothing came: leave the port free for a while, or try_lock_port() users would never get it.
+            // Host data meanwhile waits in the serial driver's buffer
+            port.unlock();
+            std::this_thread::sleep_for(options_.idle_backoff);
+        }
+    }
+}
@@ -0,0 +1,362 @@
+#include <ch9329/HidRpc.hpp>
+
+namespace ender {
+    using protocol::Command;
+
+    HidRpcEndpoint::HidRpcEndpoint(SendPacket send) : HidRpcEndpoint(std::move(send), Options{}) {
+    }
+
+    HidRpcEndpoint::HidRpcEndpoint(SendPacket send, const Options &options)
+        : send_(std::move(send)), options_(options) {
+    }
+
+    void HidRpcEndpoint::bind(uint8_t method, Method handler) {
+        std::lock_guard lock(mutex_);
+        methods_[method] = std::move(handler);
+    }
+
+    bool HidRpcEndpoint::send_message(HidRpcKind kind, uint16_t id, uint8_t method, std::span<const uint8_t> data) {
+        const size_t fragments = std::max<size_t>((data.size() + FRAGMENT_SIZE - 1) / FRAGMENT_SIZE, 1);
+        std::array<uint8_t, protocol::MAX_PAYLOAD> packet{};
+        for (size_t f = 0; f < fragments; ++f) {
+            const auto chunk = data.subspan(f * FRAGMENT_SIZE, std::min(FRAGMENT_SIZE, data.size() - f * FRAGMENT_SIZE));
+            packet[0] = static_cast<uint8_t>(kind);
+            packet[1] = static_cast<uint8_t>(id & 0xFF);
+            packet[2] = static_cast<uint8_t>(id >> 8);
+            packet[3] = method;
+            packet[4] = static_cast<uint8_t>(f);
+            packet[5] = static_cast<uint8_t>(fragments);
+            packet[6] = static_cast<uint8_t>(chunk.size());
+            std::ranges::copy(chunk, packet.begin() + HEADER_SIZE);
+            if (!send_(std::span<const uint8_t>(packet.data(), HEADER_SIZE + chunk.size()))) return false;
+        }
+        std::lock_guard lock(mutex_);
+        stats_.packets_out += fragments;
+        return true;
+    }
+
+    bool HidRpcEndpoint::assemble(Message &message, uint8_t fragment, uint8_t fragments,
+                                  std::span<const uint8_t> data) {
+        if (message.fragments != fragments) {
+            // First fragment seen (or a reused ID): start over
+            message.fragments = fragments;
+            message.received = 0;
+            message.have.assign(fragments, false);
+            message.data.assign(static_cast<size_t>(fragments) * FRAGMENT_SIZE, 0);
+            message.size = 0;
+        }
+        if (message.have[fragment]) return false;
+        message.have[fragment] = true;
+        ++message.received;
+        std::ranges::copy(data, message.data.begin() + static_cast<std::ptrdiff_t>(fragment) * FRAGMENT_SIZE);
+        if (fragment == fragments - 1) message.size = static_cast<size_t>(fragment) * FRAGMENT_SIZE + data.size();
+        if (message.received != fragments) return false;
+        message.data.resize(message.size);
+        return true;
+    }
+
+    bool HidRpcEndpoint::call(uint8_t method, std::span<const uint8_t> request, Completion done) {
+        if (request.size() > MAX_MESSAGE) return false;
+        uint16_t id;
+        {
+            std::lock_guard lock(mutex_);
+            if (pending_.size() >= options_.max_in_flight) return false;
+            do {
+                id = next_id_++;
+            } while (pending_.contains(id));
+            pending_.emplace(id, Pending{std::move(done), std::chrono::steady_clock::now() + options_.call_timeout, {}});
+            ++stats_.calls;
+        }
+        if (send_message(HidRpcKind::Request, id, method, request)) return true;
+
+        // The transport refused the request: fail the call now rather than at its deadline
+        Completion failed;
+        {
+            std::lock_guard lock(mutex_);
+            if (const auto it = pending_.find(id); it != pending_.end()) {
+                failed = std::move(it->second.done);
+                pending_.erase(it);
+                ++stats_.failed;
+            }
+        }
+        if (failed) failed(std::nullopt);
+        return true;
+    }
+
+    std::optional<std::vector<uint8_t> > HidRpcEndpoint::call(uint8_t method, std::span<const uint8_t> request) {
+        struct Result {
+            std::mutex mutex;
+            std::condition_variable cv;
+            bool finished = false;
+            std::optional<std::vector<uint8_t> > response;
+        };
+        auto result = std::make_shared<Result>();
+        const bool started = call(method, request, [result](std::optional<std::vector<uint8_t> > response) {
+            std::lock_guard lock(result->mutex);
+            result->response = std::move(response);
+            result->finished = true;
+            result->cv.notify_one();
+        });
+        if (!started) return std::nullopt;
+
+        std::unique_lock lock(result->mutex);
+        while (!result->cv.wait_for(lock, options_.call_timeout, [&result] { return result->finished; })) {
+            // Nobody may be calling expire() on this side: fail our own call once it is overdue
+            lock.unlock();
+            expire();
+            lock.lock();
+        }
+        return std::move(result->response);
+    }
+
+    void HidRpcEndpoint::receive(std::span<const uint8_t> packet) {
+        std::unique_lock lock(mutex_);
+        ++stats_.packets_in;
+        if (packet.size() < HEADER_SIZE) {
+            ++stats_.bad_packets;
+            return;
+        }
+        const auto kind = static_cast<HidRpcKind>(packet[0]);
+        const uint16_t id = static_cast<uint16_t>(packet[1] | packet[2] << 8);
+        const uint8_t method = packet[3];
+        const uint8_t fragment = packet[4];
+        const uint8_t fragments = packet[5];
+        const size_t size = packet[6];
+        if (fragments == 0 || fragment >= fragments || size > FRAGMENT_SIZE || HEADER_SIZE + size > packet.size() ||
+            (fragment + 1 < fragments && size != FRAGMENT_SIZE)) {
+            ++stats_.bad_packets;
+            return;
+        }
+        const auto data = packet.subspan(HEADER_SIZE, size);
+
+        switch (kind) {
+            case HidRpcKind::Request: {
+                if (const auto served = served_.find(id); served != served_.end()) {
+                    if (served->second.method == method) {
+                        // A resent copy of a request already served: answer again, never run the method twice
+                        ++stats_.replayed;
+                        if (!served->second.answered) return; // The handler is still running; its answer follows
+                        const auto answer_kind = served->second.kind;
+                        const std::vector<uint8_t> answer = served->second.response;
+                        lock.unlock();
+                        send_message(answer_kind, id, method, answer);
+                        return;
+                    }
+                    served_.erase(served); // The caller reused the ID for another method
+                }
+
+                auto &[message, seen] = requests_[id];
+                seen = std::chrono::steady_clock::now();
+                if (message.method != method) message.fragments = 0;
+                message.method = method;
+                if (!assemble(message, fragment, fragments, data)) return;
+
+                const std::vector<uint8_t> request = std::move(message.data);
+                requests_.erase(id);
+                const auto it = methods_.find(method);
+                const Method *handler = it != methods_.end() ? &it->second : nullptr;
+                ++stats_.served;
+                served_[id].method = method;
+                lock.unlock();
+
+                // Methods are bound before serving starts, so the handler outlives the unlocked call
+                auto response = handler ? (*handler)(request) : std::nullopt;
+                const auto answer_kind = response ? HidRpcKind::Response : HidRpcKind::Error;
+                send_message(answer_kind, id, method, response ? *response : std::vector<uint8_t>{});
+
+                lock.lock();
+                auto &served = served_[id];
+                served.answered = true;
+                served.kind = answer_kind;
+                served.response = response ? std::move(*response) : std::vector<uint8_t>{};
+                served.finished = std::chrono::steady_clock::now();
+                return;
+            }
+            case HidRpcKind::Response:
+            case HidRpcKind::Error: {
+                const auto it = pending_.find(id);
+                if (it == pending_.end()) return; // Late answer to a call that already timed out
+                std::optional<std::vector<uint8_t> > response;
+                if (kind == HidRpcKind::Response) {
+                    if (!assemble(it->second.response, fragment, fragments, data)) return;
+                    response = std::move(it->second.response.data);
+                    ++stats_.completed;
+                } else {
+                    ++stats_.failed;
+                }
+                const Completion done = std::move(it->second.done);
+                pending_.erase(it);
+                lock.unlock();
+                done(std::move(response));
+                return;
+            }
+        }
+        ++stats_.bad_packets;
+    }
+
+    size_t HidRpcEndpoint::expire() {
+        std::vector<Completion> expired;
+        {
+            std::lock_guard lock(mutex_);
+            const auto now = std::chrono::steady_clock::now();
+            for (auto it = pending_.begin(); it != pending_.end();) {
+                if (it->second.deadline > now) {
+                    ++it;
+                    continue;
+                }
+                expired.push_back(std::move(it->second.done));
+                it = pending_.erase(it);
+                ++stats_.failed;
+            }
+            std::erase_if(requests_, [&](const auto &entry) {
+                return entry.second.second + options_.call_timeout < now;
+            });
+            std::erase_if(served_, [&](const auto &entry) {
+                return entry.second.answered && entry.second.finished + options_.replay_window < now;
+            });
+        }
+        for (const auto &done: expired) done(std::nullopt);
+        return expired.size();
+    }
+
+    size_t HidRpcEndpoint::in_flight() const {
+        std::lock_guard lock(mutex_);
+        return pending_.size();
+    }
+
+    HidRpcEndpoint::Stats HidRpcEndpoint::stats() const {
+        std::lock_guard lock(mutex_);
+        return stats_;
+    }
+
+    HidRpcChannel::HidRpcChannel(CH9329Controller &controller) : HidRpcChannel(controller, Options{}) {
+    }
+
+    HidRpcChannel::HidRpcChannel(CH9329Controller &controller, const Options &options)
+        : controller_(controller), options_(options),
+          endpoint_([this](std::span<const uint8_t> packet) { return enqueue(packet); }, options.rpc) {
+    }
+
+    HidRpcChannel::~HidRpcChannel() {
+        stop();
+    }
+
+    bool HidRpcChannel::start() {
+        {
+            const auto port = controller_.lock_port();
+            if (controller_.has_hid_input_handler()) return false;
+        }
+        if (running_.exchange(true)) return true;
+        thread_ = std::thread([this] { run(); });
+        return true;
+    }
+
+    void HidRpcChannel::stop() {
+        running_.store(false);
+        if (thread_.joinable()) thread_.join();
+    }
+
+    HidRpcChannel::Stats HidRpcChannel::stats() const {
+        return {
+            packets_sent_.load(std::memory_order_relaxed),
+            packets_received_.load(std::memory_order_relaxed),
+            retransmits_.load(std::memory_order_relaxed),
+            dropped_.load(std::memory_order_relaxed)
+        };
+    }
+
+    bool HidRpcChannel::enqueue(std::span<const uint8_t> packet) {
+        const auto frame = protocol::encode<Command::SendMyHidData>(packet);
+        if (!frame) return false;
+        std::lock_guard lock(queue_mutex_);
+        outbound_.push_back({*frame, 0});
+        return true;
+    }
+
+    void HidRpcChannel::run() {
+        const auto port = controller_.lock_port();
+        const size_t window = std::max<size_t>(options_.window, 1);
+        const auto ack_wait = std::chrono::duration_cast<std::chrono::microseconds>(controller_.timeout());
+        // Same quiet time as CH9329Controller::drain_input(): one maximum-size frame plus 10 ms
+        const auto quiet = std::chrono::microseconds(protocol::MAX_FRAME_SIZE * 10 * 1000000ull /
+                                                     std::max(controller_.baud_rate(), 1u)) + 10ms;
+        std::deque<Outbound> in_flight; // Oldest first: ACKs come back in request order
+        std::vector<uint8_t> batch;
+        auto last_expire = std::chrono::steady_clock::now();
+
+        // Put packets back at the head of the queue, in order, while they have attempts left
+        auto requeue = [this](std::deque<Outbound> &packets) {
+            std::lock_guard lock(queue_mutex_);
+            for (auto it = packets.rbegin(); it != packets.rend(); ++it) {
+                if (it->attempts < options_.max_attempts) {
+                    outbound_.push_front(std::move(*it));
+                    retransmits_.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+            packets.clear();
+        };
+
+        auto deliver = [this](std::span<const uint8_t> frame) {
+            if (const auto payload = protocol::decode<Command::ReadMyHidData>(frame)) {
+                packets_received_.fetch_add(1, std::memory_order_relaxed);
+                endpoint_.receive(*payload);
+            }
+        };
+
+        while (running_.load(std::memory_order_relaxed)) {
+            batch.clear();
+            size_t written = 0;
+            {
+                std::lock_guard lock(queue_mutex_);
+                while (in_flight.size() < window && !outbound_.empty()) {
+                    auto packet = std::move(outbound_.front());
+                    outbound_.pop_front();
+                    ++packet.attempts;
+                    batch.insert(batch.end(), packet.frame.bytes.begin(), packet.frame.bytes.begin() + packet.frame.size);
+                    in_flight.push_back(std::move(packet));
+                    ++written;
+                }
+            }
+            if (written > 0) {
+                if (!controller_.write_frames(batch)) {
+                    requeue(in_flight);
+                    continue;
+                }
+                packets_sent_.fetch_add(written, std::memory_order_relaxed);
+            }
+
+            const auto frame = controller_.read_frame(in_flight.empty() ? options_.idle_wait : ack_wait);
+            if (!frame) {
+                // Nothing from the host, or the ACKs never came: resend whatever was in flight. Late ACKs of
+                // the old window would be credited to the resent packets, so drain them first, keeping the
+                // host's packets found among them
+                if (!in_flight.empty() && !controller_.link_lost()) {
+                    while (const auto late = controller_.read_frame(quiet)) {
+                        if (((*late)[3] & protocol::RESPONSE_CMD_MASK) != static_cast<uint8_t>(Command::SendMyHidData)) {
+                            deliver(*late);
+                        }
+                    }
+                }
+                requeue(in_flight);
+            } else if (const uint8_t cmd = (*frame)[3];
+                (cmd & protocol::RESPONSE_CMD_MASK) == static_cast<uint8_t>(Command::SendMyHidData)) {
+                if (!in_flight.empty()) {
+                    const auto status = protocol::decode<Command::SendMyHidData>(*frame);
+                    std::deque<Outbound> acked;
+                    acked.push_back(std::move(in_flight.front()));
+                    in_flight.pop_front();
+                    if (!status || !protocol::is_success(*status)) requeue(acked);
+                }
+            } else {
+                deliver(*frame);
+            }
+
+            if (const auto now = std::chrono::steady_clock::now(); now - last_expire >= std::chrono::milliseconds(10)) {
+                endpoint_.expire();
+                last_expire = now;
+            }
+        }
+    }
+}
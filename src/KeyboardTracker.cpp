@@ -0,0 +1,170 @@
+#include <ch9329/KeyboardTracker.hpp>
+#include <algorithm>
+#include <limits>
+
+namespace ender {
+    KeyboardTracker::KeyboardTracker(CH9329Controller &controller)
+        : controller_(controller) {
+    }
+
+    bool KeyboardTracker::press(uint8_t key) {
+        if (key == 0) return true;
+        std::lock_guard lock(mutex_);
+        if (press_count_[key] == std::numeric_limits<uint8_t>::max()) return true;
+        if (press_count_[key]++ == 0 && (key < FIRST_MODIFIER_KEY || key > LAST_MODIFIER_KEY)) {
+            assign_slot(key);
+        }
+        return flush();
+    }
+
+    bool KeyboardTracker::release(uint8_t key) {
+        if (key == 0) return true;
+        std::lock_guard lock(mutex_);
+        if (press_count_[key] == 0) return true;
+        if (--press_count_[key] == 0 && (key < FIRST_MODIFIER_KEY || key > LAST_MODIFIER_KEY)) {
+            free_slot(key);
+        }
+        return flush();
+    }
+
+    bool KeyboardTracker::set_modifiers(KeyboardCtrlKey ctrl) {
+        std::lock_guard lock(mutex_);
+        explicit_modifiers_ = static_cast<uint8_t>(ctrl);
+        return flush();
+    }
+
+    bool KeyboardTracker::release_all() {
+        std::lock_guard lock(mutex_);
+        press_count_.fill(0);
+        explicit_modifiers_ = 0;
+        slots_.fill(0);
+        slot_order_.fill(0);
+        waiting_.clear();
+        return flush();
+    }
+
+    bool KeyboardTracker::resend() {
+        std::lock_guard lock(mutex_);
+        return flush(true);
+    }
+
+    void KeyboardTracker::set_fairness_window(std::chrono::milliseconds window) {
+        std::lock_guard lock(mutex_);
+        fairness_window_ = std::max(window, std::chrono::milliseconds(1));
+    }
+
+    std::chrono::steady_clock::duration KeyboardTracker::rotation_interval() const {
+        const size_t held = std::ranges::count_if(slots_, [](uint8_t k) { return k != 0; }) + waiting_.size();
+        const size_t reports = (held + slots_.size() - 1) / slots_.size();
+        return std::chrono::duration_cast<std::chrono::steady_clock::duration>(fairness_window_) /
+               std::max<size_t>(reports, 1);
+    }
+
+    std::chrono::steady_clock::time_point KeyboardTracker::next_rotation() const {
+        std::lock_guard lock(mutex_);
+        const auto rotation = waiting_.empty() ? std::chrono::steady_clock::time_point::max()
+                                               : last_rotation_ + rotation_interval();
+        return deferred_ ? std::min(rotation, retry_at_) : rotation;
+    }
+
+    bool KeyboardTracker::poll() {
+        std::lock_guard lock(mutex_);
+        if (deferred_ && !flush()) return false;
+        if (waiting_.empty()) return true;
+        const auto now = std::chrono::steady_clock::now();
+        if (now < last_rotation_ + rotation_interval()) return true;
+        last_rotation_ = now;
+
+        // Swap out the longest-resident keys for the longest-waiting ones; the rest stay held on the host
+        const size_t count = std::min(waiting_.size(), slots_.size());
+        std::array<size_t, 6> order{0, 1, 2, 3, 4, 5};
+        std::ranges::sort(order, {}, [this](size_t i) { return slot_order_[i]; });
+        std::vector<uint8_t> evicted;
+        evicted.reserve(count);
+        for (size_t n = 0; n < count; ++n) {
+            const size_t i = order[n];
+            evicted.push_back(slots_[i]);
+            slots_[i] = waiting_[n];
+            slot_order_[i] = ++fill_counter_;
+        }
+        waiting_.erase(waiting_.begin(), waiting_.begin() + static_cast<std::ptrdiff_t>(count));
+        waiting_.insert(waiting_.end(), evicted.begin(), evicted.end());
+        return flush();
+    }
+
+    size_t KeyboardTracker::held_count() const {
+        std::lock_guard lock(mutex_);
+        return std::ranges::count_if(slots_, [](uint8_t k) { return k != 0; }) + waiting_.size();
+    }
+
+    uint8_t KeyboardTracker::modifiers() const {
+        std::lock_guard lock(mutex_);
+        return effective_modifiers();
+    }
+
+    std::array<uint8_t, 6> KeyboardTracker::slots() const {
+        std::lock_guard lock(mutex_);
+        return slots_;
+    }
+
+    bool KeyboardTracker::is_pressed(uint8_t key) const {
+        std::lock_guard lock(mutex_);
+        return press_count_[key] != 0;
+    }
+
+    uint8_t KeyboardTracker::effective_modifiers() const {
+        uint8_t mods = explicit_modifiers_;
+        for (uint8_t key = FIRST_MODIFIER_KEY; key <= LAST_MODIFIER_KEY; ++key) {
+            if (press_count_[key] != 0) mods |= static_cast<uint8_t>(1u << (key - FIRST_MODIFIER_KEY));
+        }
+        return mods;
+    }
+
+    void KeyboardTracker::assign_slot(uint8_t key) {
+        const auto free = std::ranges::find(slots_, 0);
+        if (free != slots_.end()) {
+            *free = key;
+            slot_order_[free - slots_.begin()] = ++fill_counter_;
+        } else {
+            if (waiting_.empty()) last_rotation_ = std::chrono::steady_clock::now();
+            waiting_.push_back(key);
+        }
+    }
+
+    void KeyboardTracker::free_slot(uint8_t key) {
+        if (const auto waiting = std::ranges::find(waiting_, key); waiting != waiting_.end()) {
+            waiting_.erase(waiting);
+            return;
+        }
+        const auto slot = std::ranges::find(slots_, key);
+        if (slot == slots_.end()) return;
+        // The longest-waiting key takes over the freed slot; other keys keep theirs
+        if (waiting_.empty()) {
+            *slot = 0;
+        } else {
+            *slot = waiting_.front();
+            slot_order_[slot - slots_.begin()] = ++fill_counter_;
+            waiting_.erase(waiting_.begin());
+        }
+    }
+
+    bool KeyboardTracker::flush(bool force) {
+        const uint8_t mods = effective_modifiers();
+        if (!force && mods == sent_modifiers_ && slots_ == sent_slots_) {
+            deferred_ = false;
+            return true;
+        }
+        // Never sleep for the keystroke rate limit with mutex_ held: leave the report to poll()
+        const auto sent = controller_.try_send_kb_general_data(static_cast<KeyboardCtrlKey>(mods), slots_);
+        if (!sent) {
+            deferred_ = true;
+            retry_at_ = controller_.keystroke_ready_at(slots_);
+            return true;
+        }
+        deferred_ = false;
+        if (!*sent) return false;
+        sent_modifiers_ = mods;
+        sent_slots_ = slots_;
+        return true;
+    }
+}
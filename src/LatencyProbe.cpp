@@ -0,0 +1,114 @@
+#include <ch9329/LatencyProbe.hpp>
+#include <algorithm>
+#include <thread>
+
+namespace ender {
+    namespace {
+        using clock = std::chrono::steady_clock;
+
+        std::chrono::microseconds since(clock::time_point start, clock::time_point t) {
+            return std::chrono::duration_cast<std::chrono::microseconds>(t - start);
+        }
+    }
+
+    std::chrono::microseconds LatencyStats::percentile(double p) const {
+        if (samples.empty()) return std::chrono::microseconds(0);
+        std::vector<std::chrono::microseconds> sorted;
+        sorted.reserve(samples.size());
+        for (const auto &sample: samples) sorted.push_back(sample.estimate());
+        std::ranges::sort(sorted);
+        const double rank = std::clamp(p, 0.0, 100.0) / 100.0 * static_cast<double>(sorted.size() - 1);
+        return sorted[static_cast<size_t>(rank + 0.5)];
+    }
+
+    std::chrono::microseconds LatencyStats::mean() const {
+        if (samples.empty()) return std::chrono::microseconds(0);
+        std::chrono::microseconds total{0};
+        for (const auto &sample: samples) total += sample.estimate();
+        return total / static_cast<int64_t>(samples.size());
+    }
+
+    std::chrono::microseconds LatencyStats::resolution() const {
+        std::chrono::microseconds worst{0};
+        for (const auto &sample: samples) worst = std::max(worst, sample.upper - sample.lower);
+        return worst;
+    }
+
+    std::vector<size_t> LatencyStats::histogram(std::chrono::microseconds bucket_width) const {
+        std::vector<size_t> buckets;
+        if (bucket_width.count() <= 0) return buckets;
+        for (const auto &sample: samples) {
+            const auto index = static_cast<size_t>(sample.estimate() / bucket_width);
+            if (index >= buckets.size()) buckets.resize(index + 1);
+            ++buckets[index];
+        }
+        return buckets;
+    }
+
+    LatencyProbe::LatencyProbe(CH9329Controller &controller) : LatencyProbe(controller, Options{}) {
+    }
+
+    LatencyProbe::LatencyProbe(CH9329Controller &controller, const Options &options)
+        : controller_(controller), options_(options) {
+    }
+
+    std::optional<clock::time_point> LatencyProbe::tap_key() {
+        // Wait out the keystroke rate limit before starting the clock, so pacing is not counted as latency
+        const std::array<uint8_t, 6> press{static_cast<uint8_t>(options_.key)};
+        clock::time_point sent;
+        std::optional<bool> pressed;
+        do {
+            std::this_thread::sleep_until(controller_.keystroke_ready_at(press));
+            sent = clock::now();
+            pressed = controller_.try_send_kb_general_data(KeyboardCtrlKey{}, press);
+        } while (!pressed);
+        if (!*pressed || !controller_.send_kb_general_data(KeyboardCtrlKey{}, {})) return std::nullopt;
+        return sent;
+    }
+
+    std::optional<LatencySample> LatencyProbe::measure() {
+        const auto before = controller_.get_info();
+        if (!before) return std::nullopt;
+        const bool initial = lock_led(*before, options_.key);
+
+        const auto sent = tap_key();
+        if (!sent) return std::nullopt;
+        const auto start = *sent;
+
+        LatencySample sample;
+        auto last_unchanged = start;
+        while (clock::now() - start < options_.timeout) {
+            const auto poll_sent = clock::now();
+            const auto info = controller_.get_info();
+            ++sample.polls;
+            if (info && lock_led(*info, options_.key) != initial) {
+                sample.lower = since(start, last_unchanged);
+                sample.upper = since(start, clock::now());
+                return sample;
+            }
+            if (info) last_unchanged = poll_sent;
+            if (options_.poll_interval.count() > 0) std::this_thread::sleep_for(options_.poll_interval);
+        }
+        return std::nullopt;
+    }
+
+    LatencyStats LatencyProbe::run(size_t samples) {
+        const auto initial = controller_.get_info();
+
+        LatencyStats stats;
+        stats.samples.reserve(samples);
+        for (size_t i = 0; i < samples; ++i) {
+            if (const auto sample = measure()) {
+                stats.samples.push_back(*sample);
+            } else {
+                ++stats.lost;
+            }
+            std::this_thread::sleep_for(options_.settle);
+        }
+
+        // Leave the host's lock state as it was found
+        const auto final = controller_.get_info();
+        if (initial && final && lock_led(*initial, options_.key) != lock_led(*final, options_.key)) tap_key();
+        return stats;
+    }
+}
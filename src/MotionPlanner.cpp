@@ -0,0 +1,143 @@
+#include <ch9329/MotionPlanner.hpp>
+#include <cmath>
+
+namespace ender {
+    namespace {
+        constexpr int64_t ABSOLUTE_STEPS = CoordinateMapper::ABSOLUTE_MAX + 1;
+
+        // Pixel the host lands on for an absolute position
+        double absolute_landing(uint16_t position, int32_t origin, uint32_t extent) {
+            return static_cast<double>(origin + static_cast<int64_t>(position) * extent / ABSOLUTE_STEPS);
+        }
+
+        // Smallest absolute position landing on or after the pixel
+        uint16_t absolute_for(int32_t pixel, int32_t origin, uint32_t extent) {
+            const int64_t offset = std::max<int64_t>(static_cast<int64_t>(pixel) - origin, 0);
+            const int64_t position = (offset * ABSOLUTE_STEPS + extent - 1) / extent;
+            return static_cast<uint16_t>(std::min<int64_t>(position, CoordinateMapper::ABSOLUTE_MAX));
+        }
+
+        bool lands_on(double x, double y, Point target) {
+            return static_cast<int32_t>(std::floor(x)) == target.x && static_cast<int32_t>(std::floor(y)) == target.y;
+        }
+
+        double miss(double x, double y, Point target) {
+            return std::abs(std::floor(x) - target.x) + std::abs(std::floor(y) - target.y);
+        }
+    }
+
+    MotionPlanner::MotionPlanner(const CoordinateMapper &mapper, AccelerationModel model)
+        : origin_(mapper.origin()), width_(mapper.width()), height_(mapper.height()), model_(std::move(model)) {
+    }
+
+    std::optional<Point> MotionPlanner::position() const {
+        if (!known_) return std::nullopt;
+        return Point{static_cast<int32_t>(std::floor(x_)), static_cast<int32_t>(std::floor(y_))};
+    }
+
+    void MotionPlanner::set_position(Point p) {
+        x_ = p.x;
+        y_ = p.y;
+        known_ = true;
+    }
+
+    MotionPlanner::Candidate MotionPlanner::relative_from(double x, double y, Point target) const {
+        Candidate c;
+        // Smallest displacement that puts the position inside the target pixel
+        const int dx = static_cast<int>(std::ceil(target.x - x));
+        const int dy = static_cast<int>(std::ceil(target.y - y));
+        c.reports = model_.plan(dx, dy);
+        c.x = x;
+        c.y = y;
+        for (const auto &[rx, ry]: c.reports) {
+            c.x = std::clamp(c.x + model_.pixels_for(rx), static_cast<double>(origin_.x),
+                             static_cast<double>(origin_.x) + width_ - 1);
+            c.y = std::clamp(c.y + model_.pixels_for(ry), static_cast<double>(origin_.y),
+                             static_cast<double>(origin_.y) + height_ - 1);
+        }
+        c.bytes = c.reports.size() * REL_WIRE_BYTES;
+        return c;
+    }
+
+    MotionPlanner::Candidate MotionPlanner::absolute_to(Point target) const {
+        const AbsolutePoint jump{absolute_for(target.x, origin_.x, width_), absolute_for(target.y, origin_.y, height_)};
+        Candidate c = relative_from(absolute_landing(jump.x, origin_.x, width_),
+                                    absolute_landing(jump.y, origin_.y, height_), target);
+        c.jump = jump;
+        c.bytes += ABS_WIRE_BYTES;
+        return c;
+    }
+
+    size_t MotionPlanner::plan(Point target, uint8_t buttons, std::vector<uint8_t> &batch) {
+        target.x = std::clamp<int32_t>(target.x, origin_.x, origin_.x + static_cast<int32_t>(width_) - 1);
+        target.y = std::clamp<int32_t>(target.y, origin_.y, origin_.y + static_cast<int32_t>(height_) - 1);
+        ++stats_.moves;
+
+        Candidate best = absolute_to(target);
+        if (known_) {
+            Candidate relative = relative_from(x_, y_, target);
+            // Prefer a candidate that hits the pixel, then the cheaper (or closer) one
+            const bool relative_hits = lands_on(relative.x, relative.y, target);
+            const bool absolute_hits = lands_on(best.x, best.y, target);
+            bool take = relative_hits && !absolute_hits;
+            if (relative_hits == absolute_hits) {
+                take = relative_hits ? relative.bytes <= best.bytes
+                                     : miss(relative.x, relative.y, target) <= miss(best.x, best.y, target);
+            }
+            if (take) best = std::move(relative);
+        }
+        // A button change with no movement still needs a report
+        if (!best.jump && best.reports.empty() && buttons != buttons_) best.reports.emplace_back(0, 0);
+
+        size_t frames = 0;
+        if (best.jump) {
+            const auto frame = protocol::encode<protocol::Command::SendMsAbsData>(
+                protocol::ms_abs_payload(buttons, best.jump->x, best.jump->y, 0));
+            batch.insert(batch.end(), frame.begin(), frame.end());
+            ++stats_.absolute_frames;
+            stats_.wire_bytes += ABS_WIRE_BYTES;
+            ++frames;
+        }
+        for (const auto &[rx, ry]: best.reports) {
+            const auto frame = protocol::encode<protocol::Command::SendMsRelData>(
+                protocol::ms_rel_payload(buttons, rx, ry, 0));
+            batch.insert(batch.end(), frame.begin(), frame.end());
+            ++stats_.relative_frames;
+            stats_.wire_bytes += REL_WIRE_BYTES;
+            ++frames;
+        }
+        x_ = best.x;
+        y_ = best.y;
+        known_ = true;
+        buttons_ = buttons;
+        return frames;
+    }
+
+    bool MotionPlanner::move_to(CH9329Controller &controller, Point target, MouseButton buttons) {
+        batch_.clear();
+        const size_t frames = plan(target, static_cast<uint8_t>(buttons), batch_);
+        if (frames == 0) return true;
+
+        size_t acknowledged = 0;
+        const size_t answered = controller.send_frames(batch_, frames,
+                                                       [&acknowledged](size_t, std::span<const uint8_t> response) {
+                                                           auto status = protocol::decode<
+                                                               protocol::Command::SendMsRelData>(response);
+                                                           if (!status) {
+                                                               status = protocol::decode<
+                                                                   protocol::Command::SendMsAbsData>(response);
+                                                           }
+                                                           if (status && protocol::is_success(*status)) ++acknowledged;
+                                                       });
+        if (answered != frames || acknowledged != frames) {
+            invalidate();
+            return false;
+        }
+        return true;
+    }
+
+    bool MotionPlanner::move_by(CH9329Controller &controller, int dx, int dy, MouseButton buttons) {
+        const Point from = position().value_or(origin_);
+        return move_to(controller, {from.x + dx, from.y + dy}, buttons);
+    }
+}
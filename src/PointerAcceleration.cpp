@@ -0,0 +1,151 @@
+#include <ch9329/PointerAcceleration.hpp>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <thread>
+
+namespace ender {
+    AccelerationModel::AccelerationModel() : samples_{{1, 1.0}, {127, 127.0}} {
+    }
+
+    AccelerationModel::AccelerationModel(std::vector<std::pair<int, double> > samples) {
+        std::erase_if(samples, [](const auto &s) { return s.first < 1 || s.first > 127 || !(s.second >= 0); });
+        std::ranges::sort(samples);
+        double floor = 0;
+        for (auto &[counts, pixels]: samples) {
+            if (!samples_.empty() && samples_.back().first == counts) continue;
+            floor = std::max(floor, pixels);
+            samples_.emplace_back(counts, floor);
+        }
+        if (samples_.empty()) samples_ = {{1, 1.0}, {127, 127.0}};
+    }
+
+    double AccelerationModel::pixels_for(int counts) const {
+        const int magnitude = std::min(std::abs(counts), 127);
+        if (magnitude == 0) return 0;
+        double pixels;
+        const auto upper = std::ranges::lower_bound(samples_, magnitude, {}, &std::pair<int, double>::first);
+        if (upper == samples_.begin()) {
+            // Below the first sample: scale towards zero
+            pixels = upper->second * magnitude / upper->first;
+        } else if (upper == samples_.end()) {
+            // Above the last sample: continue at the last gain
+            const auto &last = samples_.back();
+            pixels = last.second * magnitude / last.first;
+        } else {
+            const auto &lo = *(upper - 1);
+            pixels = lo.second + (upper->second - lo.second) * (magnitude - lo.first) / (upper->first - lo.first);
+        }
+        return counts < 0 ? -pixels : pixels;
+    }
+
+    std::vector<int8_t> AccelerationModel::plan_axis(int pixels) const {
+        std::vector<int8_t> reports;
+        const int sign = pixels < 0 ? -1 : 1;
+        double remaining = std::abs(pixels);
+        const double largest = pixels_for(127);
+        if (largest <= 0) return reports;
+
+        // Full-speed reports while more than one largest step remains
+        while (remaining >= largest + 0.5) {
+            reports.push_back(static_cast<int8_t>(127 * sign));
+            remaining -= largest;
+        }
+        // Then the fewest reports that close the remaining gap, each landing as close as possible
+        while (remaining >= 0.5) {
+            int best = 1;
+            for (int c = 1; c <= 127; ++c) {
+                if (std::abs(pixels_for(c) - remaining) < std::abs(pixels_for(best) - remaining)) best = c;
+            }
+            if (pixels_for(best) <= 0) break;
+            reports.push_back(static_cast<int8_t>(best * sign));
+            remaining -= pixels_for(best);
+        }
+        return reports;
+    }
+
+    std::vector<std::pair<int8_t, int8_t> > AccelerationModel::plan(int dx, int dy) const {
+        const auto x = plan_axis(dx);
+        const auto y = plan_axis(dy);
+        std::vector<std::pair<int8_t, int8_t> > reports(std::max(x.size(), y.size()));
+        for (size_t i = 0; i < reports.size(); ++i) {
+            reports[i] = {i < x.size() ? x[i] : int8_t{0}, i < y.size() ? y[i] : int8_t{0}};
+        }
+        return reports;
+    }
+
+    std::string AccelerationModel::to_string() const {
+        std::ostringstream out;
+        for (size_t i = 0; i < samples_.size(); ++i) {
+            out << (i ? " " : "") << samples_[i].first << ':' << samples_[i].second;
+        }
+        return out.str();
+    }
+
+    std::optional<AccelerationModel> AccelerationModel::parse(const std::string &text) {
+        std::istringstream in(text);
+        std::vector<std::pair<int, double> > samples;
+        std::string field;
+        while (in >> field) {
+            const auto colon = field.find(':');
+            if (colon == std::string::npos) return std::nullopt;
+            try {
+                samples.emplace_back(std::stoi(field.substr(0, colon)), std::stod(field.substr(colon + 1)));
+            } catch (const std::exception &) {
+                return std::nullopt;
+            }
+        }
+        if (samples.empty()) return std::nullopt;
+        return AccelerationModel(std::move(samples));
+    }
+
+    std::optional<AccelerationModel> calibrate_acceleration(CH9329Controller &controller,
+                                                            const CursorObserver &observer,
+                                                            const AccelerationCalibrationOptions &options) {
+        std::vector<std::pair<int, double> > samples;
+        for (const int counts: options.counts) {
+            const int c = std::clamp(counts, 1, 127);
+            const size_t reports = static_cast<size_t>(std::max(1, options.travel / c));
+
+            if (!controller.move_to_absolute(options.start.x, options.start.y)) return std::nullopt;
+            std::this_thread::sleep_for(options.settle);
+            const auto before = observer();
+            if (!before) return std::nullopt;
+
+            const auto frame = protocol::encode<protocol::Command::SendMsRelData>(
+                protocol::ms_rel_payload(0, static_cast<int8_t>(c), 0, 0));
+            std::vector<uint8_t> batch;
+            for (size_t r = 0; r < reports; ++r) batch.insert(batch.end(), frame.begin(), frame.end());
+            if (controller.send_frames(batch, reports, [](size_t, std::span<const uint8_t>) {}) != reports) {
+                return std::nullopt;
+            }
+            std::this_thread::sleep_for(options.settle);
+            const auto after = observer();
+            if (!after) return std::nullopt;
+
+            samples.emplace_back(c, static_cast<double>(after->x - before->x) / static_cast<double>(reports));
+        }
+        controller.move_to_absolute(options.start.x, options.start.y);
+        return AccelerationModel(std::move(samples));
+    }
+
+    bool move_compensated(CH9329Controller &controller, const AccelerationModel &model, int dx, int dy) {
+        const auto reports = model.plan(dx, dy);
+        if (reports.empty()) return true;
+
+        std::vector<uint8_t> batch;
+        batch.reserve(reports.size() * protocol::request_frame_size_v<protocol::Command::SendMsRelData>);
+        for (const auto &[x, y]: reports) {
+            const auto frame = protocol::encode<protocol::Command::SendMsRelData>(protocol::ms_rel_payload(0, x, y, 0));
+            batch.insert(batch.end(), frame.begin(), frame.end());
+        }
+        size_t acknowledged = 0;
+        const size_t answered = controller.send_frames(batch, reports.size(),
+                                                       [&acknowledged](size_t, std::span<const uint8_t> response) {
+                                                           const auto status = protocol::decode<
+                                                               protocol::Command::SendMsRelData>(response);
+                                                           if (status && protocol::is_success(*status)) ++acknowledged;
+                                                       });
+        return answered == reports.size() && acknowledged == reports.size();
+    }
+}
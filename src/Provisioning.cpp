@@ -0,0 +1,199 @@
+#include <ch9329/Provisioning.hpp>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace ender {
+    namespace {
+        constexpr std::array<uint8_t, 4> PROFILE_MAGIC = {'C', 'H', '9', 'P'};
+        constexpr uint8_t PROFILE_VERSION = 1;
+        constexpr size_t MAX_USB_STRING = 23;
+
+        constexpr std::array<UsbStringType, 3> STRING_TYPES = {
+            UsbStringType::Manufacturer, UsbStringType::Product, UsbStringType::SerialNumber
+        };
+
+        struct DeviceState {
+            ParaConfig config{};
+            std::array<std::string, 3> strings;
+        };
+
+        std::optional<DeviceState> read_state(CH9329Controller &controller) {
+            DeviceState state;
+            const auto config = controller.get_para_config();
+            if (!config) return std::nullopt;
+            state.config = *config;
+            for (size_t i = 0; i < STRING_TYPES.size(); ++i) {
+                const auto str = controller.get_usb_string(STRING_TYPES[i]);
+                if (!str) return std::nullopt;
+                state.strings[i] = str->content;
+            }
+            return state;
+        }
+
+        bool matches(const DeviceState &state, const DeviceState &wanted) {
+            return state.config.raw_bytes == wanted.config.raw_bytes && state.strings == wanted.strings;
+        }
+
+        std::unique_ptr<CH9329Controller> open(const std::string &port, unsigned int baud_rate) {
+            try {
+                return std::make_unique<CH9329Controller>(port, baud_rate);
+            } catch (const boost::system::system_error &) {
+                return nullptr;
+            }
+        }
+
+        void provision_one(const DeviceState &wanted, unsigned int final_baud, const ProvisionTarget &target,
+                           const ProvisionOptions &options, ProvisionResult &result) {
+            auto controller = open(target.port, target.baud_rate);
+            const auto current = controller ? read_state(*controller) : std::nullopt;
+            if (!current) {
+                result.outcome = ProvisionOutcome::Unreachable;
+                return;
+            }
+            if (matches(*current, wanted)) {
+                result.outcome = ProvisionOutcome::AlreadyProvisioned;
+                return;
+            }
+
+            // Strings first: the configuration may change the baud rate, which only takes effect on reset
+            for (size_t i = 0; i < STRING_TYPES.size(); ++i) {
+                if (current->strings[i] == wanted.strings[i]) continue;
+                if (!controller->set_usb_string(STRING_TYPES[i], wanted.strings[i])) {
+                    result.outcome = ProvisionOutcome::WriteFailed;
+                    return;
+                }
+                result.strings_written[i] = true;
+            }
+            if (current->config.raw_bytes != wanted.config.raw_bytes) {
+                if (!controller->set_para_config(wanted.config)) {
+                    result.outcome = ProvisionOutcome::WriteFailed;
+                    return;
+                }
+                result.config_written = true;
+            }
+            if (!controller->reset()) {
+                result.outcome = ProvisionOutcome::ResetFailed;
+                return;
+            }
+            controller = nullptr; // Reopen after the reset, at the baud rate the new configuration selects
+
+            result.outcome = ProvisionOutcome::Unreachable;
+            for (unsigned int attempt = 0; attempt < std::max(options.verify_attempts, 1u); ++attempt) {
+                std::this_thread::sleep_for(options.reset_settle);
+                controller = open(target.port, final_baud);
+                const auto after = controller ? read_state(*controller) : std::nullopt;
+                if (!after) continue;
+                result.outcome = matches(*after, wanted) ? ProvisionOutcome::Provisioned
+                                                         : ProvisionOutcome::VerifyFailed;
+                return;
+            }
+        }
+    }
+
+    std::string DeviceProfile::serial_for(size_t index) const {
+        std::string serial;
+        const uint64_t number = serial_base + index;
+        for (size_t i = 0; i < serial_template.size();) {
+            if (serial_template[i] != '#') {
+                serial += serial_template[i++];
+                continue;
+            }
+            size_t width = 0;
+            while (i < serial_template.size() && serial_template[i] == '#') ++width, ++i;
+            std::string digits = std::to_string(number);
+            if (digits.size() < width) digits.insert(0, width - digits.size(), '0');
+            serial += digits;
+        }
+        return serial;
+    }
+
+    uint32_t DeviceProfile::baud_rate() const {
+        const auto &b = config.raw_bytes;
+        return static_cast<uint32_t>(b[3]) << 24 | static_cast<uint32_t>(b[4]) << 16 |
+               static_cast<uint32_t>(b[5]) << 8 | b[6];
+    }
+
+    std::vector<uint8_t> DeviceProfile::serialize() const {
+        std::vector<uint8_t> blob(PROFILE_MAGIC.begin(), PROFILE_MAGIC.end());
+        blob.push_back(PROFILE_VERSION);
+        blob.insert(blob.end(), config.raw_bytes.begin(), config.raw_bytes.end());
+        for (int shift = 0; shift < 32; shift += 8) blob.push_back(static_cast<uint8_t>(serial_base >> shift));
+        for (const auto *str: {&manufacturer, &product, &serial_template}) {
+            blob.push_back(static_cast<uint8_t>(str->size()));
+            blob.insert(blob.end(), str->begin(), str->end());
+        }
+        return blob;
+    }
+
+    std::optional<DeviceProfile> DeviceProfile::parse(std::span<const uint8_t> blob) {
+        constexpr size_t fixed_size = PROFILE_MAGIC.size() + 1 + sizeof(ParaConfig::raw_bytes) + 4;
+        if (blob.size() < fixed_size) return std::nullopt;
+        if (!std::equal(PROFILE_MAGIC.begin(), PROFILE_MAGIC.end(), blob.begin())) return std::nullopt;
+        if (blob[PROFILE_MAGIC.size()] != PROFILE_VERSION) return std::nullopt;
+
+        DeviceProfile profile;
+        auto rest = blob.subspan(PROFILE_MAGIC.size() + 1);
+        std::ranges::copy(rest.first(profile.config.raw_bytes.size()), profile.config.raw_bytes.begin());
+        rest = rest.subspan(profile.config.raw_bytes.size());
+        for (int i = 0; i < 4; ++i) profile.serial_base |= static_cast<uint32_t>(rest[i]) << (8 * i);
+        rest = rest.subspan(4);
+
+        for (auto *str: {&profile.manufacturer, &profile.product, &profile.serial_template}) {
+            if (rest.empty() || rest[0] > rest.size() - 1) return std::nullopt;
+            str->assign(rest.begin() + 1, rest.begin() + 1 + rest[0]);
+            rest = rest.subspan(1 + rest[0]);
+        }
+        if (!rest.empty()) return std::nullopt;
+        if (profile.manufacturer.size() > MAX_USB_STRING || profile.product.size() > MAX_USB_STRING) {
+            return std::nullopt;
+        }
+        return profile;
+    }
+
+    const char *to_string(ProvisionOutcome outcome) {
+        switch (outcome) {
+            case ProvisionOutcome::AlreadyProvisioned: return "already provisioned";
+            case ProvisionOutcome::Provisioned: return "provisioned";
+            case ProvisionOutcome::Unreachable: return "unreachable";
+            case ProvisionOutcome::WriteFailed: return "write failed";
+            case ProvisionOutcome::ResetFailed: return "reset failed";
+            case ProvisionOutcome::VerifyFailed: return "verify failed";
+        }
+        return "unknown";
+    }
+
+    std::vector<ProvisionResult> provision(const DeviceProfile &profile,
+                                           const std::vector<ProvisionTarget> &targets,
+                                           const ProvisionOptions &options) {
+        std::vector<ProvisionResult> results(targets.size());
+        std::atomic<size_t> next{0};
+
+        auto worker = [&] {
+            for (size_t i = next.fetch_add(1); i < targets.size(); i = next.fetch_add(1)) {
+                const auto start = std::chrono::steady_clock::now();
+                auto &result = results[i];
+                result.port = targets[i].port;
+                result.serial = profile.serial_for(i);
+
+                DeviceState wanted;
+                wanted.config = profile.config;
+                wanted.strings = {profile.manufacturer, profile.product, result.serial};
+                if (result.serial.size() > MAX_USB_STRING) {
+                    result.outcome = ProvisionOutcome::WriteFailed;
+                } else {
+                    const uint32_t baud = profile.baud_rate();
+                    provision_one(wanted, baud != 0 ? baud : targets[i].baud_rate, targets[i], options, result);
+                }
+                result.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - start);
+            }
+        };
+
+        std::vector<std::thread> workers;
+        const size_t count = std::min(std::max<size_t>(options.threads, 1), targets.size());
+        for (size_t t = 0; t < count; ++t) workers.emplace_back(worker);
+        for (auto &t: workers) t.join();
+        return results;
+    }
+}
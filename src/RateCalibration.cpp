@@ -0,0 +1,134 @@
+#include <ch9329/RateCalibration.hpp>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+namespace ender {
+    namespace {
+        std::map<std::string, double> read_rates(const std::string &path) {
+            std::map<std::string, double> rates;
+            std::ifstream in(path);
+            std::string line;
+            while (std::getline(in, line)) {
+                std::istringstream fields(line);
+                std::string host;
+                double rate = 0;
+                if (fields >> host >> rate && rate > 0) rates[host] = rate;
+            }
+            return rates;
+        }
+    }
+
+    RateCalibrationResult calibrate_key_rate(CH9329Controller &controller, const RateCalibrationOptions &options) {
+        RateCalibrationResult result;
+        const double previous_rate = controller.keystroke_rate();
+        const auto initial = controller.get_info();
+        if (!initial) return result;
+        bool state = lock_led(*initial, options.key);
+
+        // Long enough to overflow host_buffer at a host rate of rate / step: host_buffer / (1 - 1 / step) presses
+        const double step = std::max(options.step, 1.01);
+        const auto overflow = static_cast<size_t>(std::ceil(static_cast<double>(options.host_buffer) / (1 - 1 / step)));
+        const size_t burst = std::max(options.burst, overflow + 1) | 1;
+        const std::vector<uint8_t> taps(burst + 2 * (options.bursts_per_rate - 1), static_cast<uint8_t>(options.key));
+
+        // One trial: false if a burst was dropped; empty if the device stopped answering
+        auto trial = [&](double rate) -> std::optional<bool> {
+            controller.set_keystroke_rate(rate);
+            bool passed = true;
+            for (size_t b = 0; b < options.bursts_per_rate && passed; ++b) {
+                const auto keys = std::span<const uint8_t>(taps).first(burst + 2 * b);
+                passed = controller.type_keys(keys);
+                std::this_thread::sleep_for(options.settle);
+
+                // Resynchronise with whatever the host did, so a failed burst does not poison the next
+                const auto info = controller.get_info();
+                if (!info) return std::nullopt;
+                passed = passed && lock_led(*info, options.key) != state;
+                state = lock_led(*info, options.key);
+            }
+            return passed;
+        };
+
+        bool device_lost = false;
+        for (double rate = options.start_rate; rate <= options.max_rate; rate *= step) {
+            const auto passed = trial(rate);
+            if (!passed) {
+                device_lost = true;
+                break;
+            }
+            result.trials.push_back({rate, *passed});
+            if (!*passed) break;
+            result.verified_rate = rate;
+        }
+
+        // A calibration the device did not see through verifies nothing. Never leave pacing off (rate 0)
+        // because nothing verified: keep the earlier limit, or the slowest trial's safe rate if there was none
+        if (device_lost) result.verified_rate = 0;
+        result.safe_rate = result.verified_rate * options.safety;
+        if (result.ok()) {
+            controller.set_keystroke_rate(result.safe_rate);
+        } else if (previous_rate > 0) {
+            controller.set_keystroke_rate(previous_rate);
+        } else {
+            controller.set_keystroke_rate(options.start_rate * options.safety);
+        }
+
+        // Restore the lock state, as last seen if the device stopped answering
+        if (state != lock_led(*initial, options.key)) {
+            const uint8_t key = static_cast<uint8_t>(options.key);
+            controller.type_keys(std::span(&key, 1));
+        }
+        return result;
+    }
+
+    HostRateStore::HostRateStore() {
+        const char *config = std::getenv("XDG_CONFIG_HOME");
+        const char *home = std::getenv("HOME");
+        const std::filesystem::path base = config && *config ? std::filesystem::path(config)
+                                           : home ? std::filesystem::path(home) / ".config"
+                                           : std::filesystem::path(".");
+        path_ = (base / "ch9329" / "host-rates").string();
+    }
+
+    HostRateStore::HostRateStore(std::string path) : path_(std::move(path)) {
+    }
+
+    std::optional<double> HostRateStore::load(const std::string &host_id) const {
+        const auto rates = read_rates(path_);
+        const auto it = rates.find(host_id);
+        if (it == rates.end()) return std::nullopt;
+        return it->second;
+    }
+
+    bool HostRateStore::save(const std::string &host_id, double rate) const {
+        if (host_id.empty() || host_id.find_first_of(" \t\n") != std::string::npos || rate <= 0) return false;
+        auto rates = read_rates(path_);
+        rates[host_id] = rate;
+
+        std::error_code ec;
+        const auto parent = std::filesystem::path(path_).parent_path();
+        if (!parent.empty()) std::filesystem::create_directories(parent, ec);
+
+        // Write a sibling file and rename it over the store so readers never see a partial file
+        const std::string tmp = path_ + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::trunc);
+            for (const auto &[host, r]: rates) out << host << ' ' << r << '\n';
+            if (!out) return false;
+        }
+        std::filesystem::rename(tmp, path_, ec);
+        return !ec;
+    }
+
+    bool HostRateStore::apply(CH9329Controller &controller, const std::string &host_id) const {
+        const auto rate = load(host_id);
+        if (!rate) return false;
+        controller.set_keystroke_rate(*rate);
+        return true;
+    }
+}
@@ -0,0 +1,120 @@
+#include <ch9329/ScrollEngine.hpp>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+namespace ender {
+    namespace {
+        // Fraction of the distance due after the given interval
+        double progress(const ScrollOptions &options, size_t tick, size_t ticks) {
+            switch (options.profile) {
+                case ScrollProfile::Constant:
+                    return static_cast<double>(tick) / static_cast<double>(ticks);
+                case ScrollProfile::EaseOut: {
+                    const double remaining = 1.0 - static_cast<double>(tick) / static_cast<double>(ticks);
+                    return 1.0 - remaining * remaining * remaining;
+                }
+                case ScrollProfile::Fling:
+                    return 1.0 - std::pow(options.decay, static_cast<double>(tick));
+            }
+            return 1.0;
+        }
+
+        // Intervals the profile needs before the rounded position settles on the distance
+        size_t tick_count(const ScrollOptions &options, int distance) {
+            if (options.profile == ScrollProfile::Fling) {
+                const double decay = std::clamp(options.decay, 0.0, 0.999);
+                if (decay <= 0.0) return 1;
+                // Remaining distance distance * decay^k drops below half a notch
+                return static_cast<size_t>(std::ceil(std::log(0.5 / std::abs(distance)) / std::log(decay)));
+            }
+            const auto interval = std::max<int64_t>(options.interval.count(), 1);
+            const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(options.duration).count();
+            return static_cast<size_t>(std::max<int64_t>(duration / interval, 1));
+        }
+    }
+
+    int ScrollPlan::total() const {
+        int sum = 0;
+        for (const auto &step: steps) sum += step.wheel;
+        return sum;
+    }
+
+    ScrollPlan plan_scroll(int distance, const ScrollOptions &options) {
+        ScrollPlan plan;
+        if (distance == 0) return plan;
+        // Symmetric range, so std::abs() and the remaining/due arithmetic below cannot overflow
+        distance = std::max(distance, -std::numeric_limits<int>::max());
+        const int max_step = std::clamp(options.max_step, 1, 127);
+
+        if (options.interval.count() == 0) {
+            // No pacing: the fewest reports that cover the distance
+            for (int remaining = distance; remaining != 0;) {
+                const int step = std::clamp(remaining, -max_step, max_step);
+                plan.steps.push_back({static_cast<int8_t>(step), {}});
+                remaining -= step;
+            }
+            return plan;
+        }
+
+        ScrollOptions profile = options;
+        profile.decay = std::clamp(options.decay, 0.0, 0.999);
+        const size_t ticks = tick_count(profile, distance);
+        int sent = 0;
+        for (size_t tick = 1; sent != distance; ++tick) {
+            const int due = tick >= ticks
+                                ? distance
+                                : static_cast<int>(std::lround(distance * progress(profile, tick, ticks)));
+            const int step = std::clamp(due - sent, -max_step, max_step);
+            if (step == 0) continue;
+            plan.steps.push_back({static_cast<int8_t>(step), options.interval * static_cast<int64_t>(tick - 1)});
+            sent += step;
+        }
+        return plan;
+    }
+
+    bool scroll(CH9329Controller &controller, const ScrollPlan &plan) {
+        using protocol::Command;
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<uint8_t> batch;
+        bool ok = true;
+        for (size_t i = 0; i < plan.steps.size();) {
+            // Gather the steps due together
+            batch.clear();
+            size_t count = 0;
+            const auto at = plan.steps[i].at;
+            for (; i < plan.steps.size() && plan.steps[i].at == at; ++i, ++count) {
+                const auto frame = protocol::encode<Command::SendMsRelData>(
+                    protocol::ms_rel_payload(0x00, 0, 0, plan.steps[i].wheel));
+                batch.insert(batch.end(), frame.begin(), frame.end());
+            }
+            std::this_thread::sleep_until(start + at);
+
+            size_t acknowledged = 0;
+            const size_t answered = controller.send_frames(batch, count,
+                                                           [&acknowledged](size_t, std::span<const uint8_t> response) {
+                                                               const auto status = protocol::decode<
+                                                                   Command::SendMsRelData>(response);
+                                                               if (status && protocol::is_success(*status)) {
+                                                                   ++acknowledged;
+                                                               }
+                                                           });
+            ok = ok && answered == count && acknowledged == count;
+        }
+        return ok;
+    }
+
+    task<bool> co_scroll(CH9329Controller &controller, ScrollPlan plan) {
+        asio::steady_timer timer(controller.io_context());
+        const auto start = asio::steady_timer::clock_type::now();
+        bool ok = true;
+        for (const auto &step: plan.steps) {
+            timer.expires_at(start + step.at);
+            boost::system::error_code ec;
+            co_await timer.async_wait(asio::redirect_error(asio::use_awaitable, ec));
+            const bool sent = co_await controller.co_send_ms_rel_data(MouseButton::None, 0, 0, step.wheel);
+            ok = ok && sent;
+        }
+        co_return ok;
+    }
+}
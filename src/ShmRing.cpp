@@ -0,0 +1,255 @@
+#include <ch9329/ShmRing.hpp>
+#include <boost/system/system_error.hpp>
+#include <bit>
+#include <cerrno>
+#include <climits>
+#include <new>
+#include <thread>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+namespace ender {
+    namespace {
+        constexpr uint32_t RING_MAGIC = 0x39333243; // "C239"
+        constexpr uint32_t RING_VERSION = 2;
+
+        [[noreturn]] void throw_errno(const char *what) {
+            throw boost::system::system_error(errno, boost::system::system_category(), what);
+        }
+
+        std::string shm_path(const std::string &name) {
+            return name.starts_with('/') ? name : "/" + name;
+        }
+
+        // A ring left by a consumer that exited (or crashed before finishing setup) may be replaced;
+        // one whose consumer is still running may not
+        bool ring_is_stale(const std::string &path) {
+            const int fd = ::shm_open(path.c_str(), O_RDONLY, 0);
+            if (fd < 0) return errno == ENOENT;
+            struct stat st{};
+            bool stale = true;
+            if (::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= sizeof(ShmRingHeader)) {
+                void *mapping = ::mmap(nullptr, sizeof(ShmRingHeader), PROT_READ, MAP_SHARED, fd, 0);
+                if (mapping != MAP_FAILED) {
+                    const auto *header = static_cast<const ShmRingHeader *>(mapping);
+                    if (header->magic == RING_MAGIC && header->version == RING_VERSION && header->owner_pid > 0) {
+                        stale = ::kill(header->owner_pid, 0) != 0 && errno == ESRCH;
+                    }
+                    ::munmap(mapping, sizeof(ShmRingHeader));
+                }
+            }
+            ::close(fd);
+            return stale;
+        }
+
+        size_t mapping_size_for(size_t capacity) {
+            return sizeof(ShmRingHeader) + capacity * sizeof(ShmRecord);
+        }
+
+        // Shared (not process-private) futex so waiters and wakers may live in different processes
+        void futex_wait(std::atomic<uint32_t> &word, uint32_t expected, std::chrono::milliseconds timeout) {
+#ifdef __linux__
+            timespec ts{};
+            ts.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+            ts.tv_nsec = static_cast<long>((timeout.count() % 1000) * 1000000);
+            ::syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+#else
+            // No futex: poll the doorbell word at a coarse interval
+            const auto deadline = std::chrono::steady_clock::now() + timeout;
+            while (word.load(std::memory_order_acquire) == expected && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+#endif
+        }
+
+        void futex_wake(std::atomic<uint32_t> &word) {
+#ifdef __linux__
+            ::syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+            (void) word;
+#endif
+        }
+    }
+
+    std::optional<protocol::Command> command_for(ShmRecordType type) {
+        switch (type) {
+            case ShmRecordType::RelMove: return protocol::Command::SendMsRelData;
+            case ShmRecordType::AbsMove: return protocol::Command::SendMsAbsData;
+            case ShmRecordType::KeyState: return protocol::Command::SendKbGeneralData;
+            case ShmRecordType::MediaKey: return protocol::Command::SendKbMediaData;
+            case ShmRecordType::HidBlob: return protocol::Command::SendMyHidData;
+        }
+        return std::nullopt;
+    }
+
+    ShmRingProducer::ShmRingProducer(const std::string &name) {
+        const int fd = ::shm_open(shm_path(name).c_str(), O_RDWR, 0);
+        if (fd < 0) throw_errno("shm_open");
+        struct stat st{};
+        if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ShmRingHeader)) {
+            ::close(fd);
+            throw boost::system::system_error(EINVAL, boost::system::system_category(), "shm ring too small");
+        }
+        mapping_size_ = static_cast<size_t>(st.st_size);
+        mapping_ = ::mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping_ == MAP_FAILED) throw_errno("mmap");
+
+        header_ = static_cast<ShmRingHeader *>(mapping_);
+        records_ = reinterpret_cast<ShmRecord *>(static_cast<uint8_t *>(mapping_) + sizeof(ShmRingHeader));
+        if (header_->magic != RING_MAGIC || header_->version != RING_VERSION ||
+            header_->record_size != sizeof(ShmRecord) || mapping_size_ < mapping_size_for(header_->capacity)) {
+            ::munmap(mapping_, mapping_size_);
+            throw boost::system::system_error(EPROTO, boost::system::system_category(), "shm ring layout mismatch");
+        }
+    }
+
+    ShmRingProducer::~ShmRingProducer() {
+        ::munmap(mapping_, mapping_size_);
+    }
+
+    bool ShmRingProducer::push(ShmRecordType type, std::span<const uint8_t> payload) {
+        if (payload.size() > protocol::MAX_PAYLOAD) return false;
+        const uint64_t mask = header_->capacity - 1;
+
+        // Bounded MPMC handoff: a slot is free for position pos when its sequence equals pos
+        uint64_t pos = header_->head.load(std::memory_order_relaxed);
+        ShmRecord *record;
+        for (;;) {
+            record = &records_[pos & mask];
+            const uint64_t seq = record->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<int64_t>(seq - pos);
+            if (diff == 0) {
+                if (header_->head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                header_->dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = header_->head.load(std::memory_order_relaxed);
+            }
+        }
+
+        record->type = static_cast<uint8_t>(type);
+        record->size = static_cast<uint8_t>(payload.size());
+        std::ranges::copy(payload, record->payload.begin());
+        record->sequence.store(pos + 1, std::memory_order_release);
+
+        // Only pay for the wake-up syscall when the consumer is parked. The fence keeps the flag load from
+        // moving ahead of the publish above; the consumer fences between setting the flag and re-checking
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (header_->consumer_sleeping.load(std::memory_order_seq_cst) != 0) {
+            header_->doorbell.fetch_add(1, std::memory_order_seq_cst);
+            futex_wake(header_->doorbell);
+        }
+        return true;
+    }
+
+    bool ShmRingProducer::push_rel_move(uint8_t buttons, int8_t x_delta, int8_t y_delta, int8_t wheel) {
+        return push(ShmRecordType::RelMove, protocol::ms_rel_payload(buttons, x_delta, y_delta, wheel));
+    }
+
+    bool ShmRingProducer::push_abs_move(uint8_t buttons, uint16_t x, uint16_t y, int8_t wheel) {
+        return push(ShmRecordType::AbsMove, protocol::ms_abs_payload(buttons, x, y, wheel));
+    }
+
+    bool ShmRingProducer::push_key_state(uint8_t modifiers, const std::array<uint8_t, 6> &keys) {
+        return push(ShmRecordType::KeyState, protocol::kb_general_payload(modifiers, keys));
+    }
+
+    bool ShmRingProducer::push_media_key(uint8_t report_id, uint16_t keycode) {
+        return push(ShmRecordType::MediaKey, protocol::kb_media_payload(report_id, keycode));
+    }
+
+    bool ShmRingProducer::push_hid(std::span<const uint8_t> data) {
+        return push(ShmRecordType::HidBlob, data);
+    }
+
+    ShmRingConsumer::ShmRingConsumer(const std::string &name, size_t capacity)
+        : name_(shm_path(name)) {
+        capacity = std::bit_ceil(std::max<size_t>(capacity, 2));
+        mapping_size_ = mapping_size_for(capacity);
+
+        if (!ring_is_stale(name_)) {
+            throw boost::system::system_error(EBUSY, boost::system::system_category(),
+                                              "shm ring owned by a running consumer");
+        }
+        ::shm_unlink(name_.c_str()); // Start clean if a previous consumer crashed
+        const int fd = ::shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0660);
+        if (fd < 0) throw_errno("shm_open");
+        if (::ftruncate(fd, static_cast<off_t>(mapping_size_)) != 0) {
+            ::close(fd);
+            ::shm_unlink(name_.c_str());
+            throw_errno("ftruncate");
+        }
+        mapping_ = ::mmap(nullptr, mapping_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping_ == MAP_FAILED) {
+            ::shm_unlink(name_.c_str());
+            throw_errno("mmap");
+        }
+
+        records_ = reinterpret_cast<ShmRecord *>(static_cast<uint8_t *>(mapping_) + sizeof(ShmRingHeader));
+        for (size_t i = 0; i < capacity; ++i) {
+            auto *record = new(&records_[i]) ShmRecord{};
+            record->sequence.store(i, std::memory_order_relaxed);
+        }
+        header_ = new(mapping_) ShmRingHeader{};
+        header_->capacity = static_cast<uint32_t>(capacity);
+        header_->record_size = sizeof(ShmRecord);
+        header_->version = RING_VERSION;
+        header_->owner_pid = static_cast<int32_t>(::getpid());
+        std::atomic_thread_fence(std::memory_order_release);
+        header_->magic = RING_MAGIC; // Written last: producers reject the mapping until it is set
+    }
+
+    ShmRingConsumer::~ShmRingConsumer() {
+        ::munmap(mapping_, mapping_size_);
+        ::shm_unlink(name_.c_str());
+    }
+
+    bool ShmRingConsumer::ready() const {
+        const uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+        const auto &record = records_[tail & (header_->capacity - 1)];
+        return record.sequence.load(std::memory_order_acquire) == tail + 1;
+    }
+
+    size_t ShmRingConsumer::drain(const RecordHandler &handler, size_t max_records) {
+        const uint64_t mask = header_->capacity - 1;
+        uint64_t tail = header_->tail.load(std::memory_order_relaxed);
+        size_t count = 0;
+        while (count < max_records) {
+            auto &record = records_[tail & mask];
+            if (record.sequence.load(std::memory_order_acquire) != tail + 1) break;
+            handler(static_cast<ShmRecordType>(record.type),
+                    std::span<const uint8_t>(record.payload.data(), std::min<size_t>(record.size, protocol::MAX_PAYLOAD)));
+            record.sequence.store(tail + header_->capacity, std::memory_order_release);
+            ++tail;
+            ++count;
+        }
+        header_->tail.store(tail, std::memory_order_relaxed);
+        return count;
+    }
+
+    bool ShmRingConsumer::wait(std::chrono::milliseconds timeout) {
+        if (ready()) return true;
+        const uint32_t bell = header_->doorbell.load(std::memory_order_seq_cst);
+        header_->consumer_sleeping.store(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        // Re-check after announcing: a producer that published before seeing the flag is caught here
+        if (!ready()) futex_wait(header_->doorbell, bell, timeout);
+        header_->consumer_sleeping.store(0, std::memory_order_relaxed);
+        return ready();
+    }
+
+    void ShmRingConsumer::notify() {
+        header_->doorbell.fetch_add(1, std::memory_order_seq_cst);
+        futex_wake(header_->doorbell);
+    }
+}
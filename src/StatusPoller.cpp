@@ -0,0 +1,78 @@
+#include <ch9329/StatusPoller.hpp>
+
+namespace ender {
+    StatusPoller::StatusPoller(CH9329Controller &controller, const Options &options)
+        : controller_(controller), options_(options) {
+    }
+
+    StatusPoller::StatusPoller(CH9329Controller &controller) : StatusPoller(controller, Options{}) {
+    }
+
+    StatusPoller::~StatusPoller() {
+        stop();
+    }
+
+    void StatusPoller::start() {
+        {
+            std::lock_guard lock(mutex_);
+            if (running_) return;
+            running_ = true;
+        }
+        thread_ = std::thread([this] { run(); });
+    }
+
+    void StatusPoller::stop() {
+        {
+            std::lock_guard lock(mutex_);
+            running_ = false;
+        }
+        wake_.notify_all();
+        if (thread_.joinable()) thread_.join();
+    }
+
+    bool StatusPoller::sleep_until(std::chrono::steady_clock::time_point deadline) {
+        std::unique_lock lock(mutex_);
+        wake_.wait_until(lock, deadline, [this] { return !running_; });
+        return running_;
+    }
+
+    void StatusPoller::run() {
+        using clock = std::chrono::steady_clock;
+        auto due = clock::now();
+
+        while (sleep_until(due)) {
+            const auto give_up = due + options_.max_delay;
+            std::optional<DeviceInfo> info;
+
+            for (;;) {
+                const auto now = clock::now();
+                const auto quiet_from = controller_.last_activity() + options_.idle_gap;
+                if (now < quiet_from && now < give_up) {
+                    if (!sleep_until(std::min(quiet_from, give_up))) return;
+                    continue;
+                }
+                // In a gap, only take the port if no command has started meanwhile
+                auto port = now >= give_up ? controller_.lock_port() : controller_.try_lock_port();
+                if (port.owns_lock()) {
+                    info = controller_.poll_info();
+                    break;
+                }
+                if (!sleep_until(now + options_.idle_gap)) return;
+            }
+
+            StatusSnapshot snapshot = snapshot_.load();
+            if (info) {
+                snapshot.info = *info;
+                snapshot.refreshed = clock::now();
+                snapshot.valid = true;
+                snapshot.stale = false;
+            } else {
+                snapshot.stale = true;
+            }
+            snapshot_.store(snapshot);
+
+            due += options_.interval;
+            if (due < clock::now()) due = clock::now() + options_.interval;
+        }
+    }
+}
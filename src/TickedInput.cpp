@@ -0,0 +1,181 @@
+#include <ch9329/TickedInput.hpp>
+#include <algorithm>
+
+namespace ender {
+    namespace {
+        constexpr unsigned int BITS_PER_BYTE = 10; // 8N1: start + 8 data + stop
+        constexpr size_t ACK_FRAME_SIZE = protocol::FRAME_OVERHEAD + 1;
+
+        // Largest report a tick may carry plus the ACK the device returns for it
+        constexpr size_t TICK_BYTES = std::max({
+                                          protocol::request_frame_size_v<protocol::Command::SendKbGeneralData>,
+                                          protocol::request_frame_size_v<protocol::Command::SendMsAbsData>,
+                                          protocol::request_frame_size_v<protocol::Command::SendMsRelData>
+                                      }) + ACK_FRAME_SIZE;
+
+        constexpr std::array<unsigned int, 4> HID_POLL_RATES = {1000, 500, 250, 125};
+
+        int8_t take_clamped(std::atomic<int32_t> &accumulator) {
+            const int32_t total = accumulator.exchange(0, std::memory_order_acq_rel);
+            const int32_t sent = std::clamp(total, -127, 127);
+            if (sent != total) accumulator.fetch_add(total - sent, std::memory_order_acq_rel);
+            return static_cast<int8_t>(sent);
+        }
+
+        uint64_t pack_keyboard(uint8_t ctrl, const std::array<uint8_t, 6> &keys) {
+            uint64_t packed = ctrl;
+            for (size_t i = 0; i < keys.size(); ++i) packed |= static_cast<uint64_t>(keys[i]) << (8 * (i + 1));
+            return packed;
+        }
+    }
+
+    TickedInput::TickedInput(CH9329Controller &controller, unsigned int tick_rate_hz)
+        : controller_(controller), tick_rate_(fit_tick_rate(tick_rate_hz, controller.baud_rate())) {
+    }
+
+    TickedInput::~TickedInput() {
+        stop();
+    }
+
+    unsigned int TickedInput::max_tick_rate(unsigned int baud_rate) {
+        return std::max(1u, static_cast<unsigned int>(baud_rate / (TICK_BYTES * BITS_PER_BYTE)));
+    }
+
+    unsigned int TickedInput::fit_tick_rate(unsigned int requested_hz, unsigned int baud_rate) {
+        const unsigned int limit = std::min(std::max(requested_hz, 1u), max_tick_rate(baud_rate));
+        for (const unsigned int rate: HID_POLL_RATES) {
+            if (rate <= limit) return rate;
+        }
+        return limit;
+    }
+
+    void TickedInput::start() {
+        if (running_.exchange(true)) return;
+        thread_ = std::thread([this] { run(); });
+    }
+
+    void TickedInput::stop() {
+        running_.store(false);
+        if (thread_.joinable()) thread_.join();
+    }
+
+    void TickedInput::move(int x_delta, int y_delta) {
+        x_delta_.fetch_add(x_delta, std::memory_order_acq_rel);
+        y_delta_.fetch_add(y_delta, std::memory_order_acq_rel);
+    }
+
+    void TickedInput::scroll(int wheel_delta) {
+        wheel_delta_.fetch_add(wheel_delta, std::memory_order_acq_rel);
+    }
+
+    void TickedInput::press_button(MouseButton button) {
+        buttons_.fetch_or(static_cast<uint8_t>(button), std::memory_order_acq_rel);
+    }
+
+    void TickedInput::release_button(MouseButton button) {
+        buttons_.fetch_and(static_cast<uint8_t>(~static_cast<uint8_t>(button)), std::memory_order_acq_rel);
+    }
+
+    void TickedInput::move_to_absolute(uint16_t x, uint16_t y, MouseButton buttons, int8_t wheel) {
+        absolute_.post({
+            std::min(x, static_cast<uint16_t>(4095)),
+            std::min(y, static_cast<uint16_t>(4095)),
+            static_cast<uint8_t>(buttons),
+            wheel
+        });
+    }
+
+    void TickedInput::set_keyboard(KeyboardCtrlKey ctrl, const std::array<uint8_t, 6> &keys) {
+        keyboard_.store(pack_keyboard(static_cast<uint8_t>(ctrl), keys), std::memory_order_release);
+    }
+
+    TickedInput::Stats TickedInput::stats() const {
+        return {
+            ticks_.load(std::memory_order_relaxed),
+            reports_.load(std::memory_order_relaxed),
+            failures_.load(std::memory_order_relaxed),
+            overruns_.load(std::memory_order_relaxed),
+            absolute_.superseded()
+        };
+    }
+
+    void TickedInput::run() {
+        const auto period = std::chrono::nanoseconds(std::chrono::seconds(1)) / tick_rate_;
+        auto next = std::chrono::steady_clock::now();
+
+        while (running_.load(std::memory_order_relaxed)) {
+            // Keyboard and mouse take turns having priority so neither can starve the other
+            const bool sent = keyboard_first_ ? (tick_keyboard() || tick_mouse()) : (tick_mouse() || tick_keyboard());
+            if (sent) keyboard_first_ = !keyboard_first_;
+            ticks_.fetch_add(1, std::memory_order_relaxed);
+
+            next += period;
+            const auto now = std::chrono::steady_clock::now();
+            if (next < now) {
+                // Late: realign to the tick grid instead of bursting to catch up
+                overruns_.fetch_add(1, std::memory_order_relaxed);
+                next = now;
+            }
+            std::this_thread::sleep_until(next);
+        }
+    }
+
+    bool TickedInput::tick_keyboard() {
+        const uint64_t state = keyboard_.load(std::memory_order_acquire);
+        if (state == sent_keyboard_) return false;
+
+        std::array<uint8_t, 6> keys{};
+        for (size_t i = 0; i < keys.size(); ++i) keys[i] = static_cast<uint8_t>(state >> (8 * (i + 1)));
+        // A press held back by the keystroke rate limit stays pending for a later tick; the tick thread never sleeps on it
+        const auto sent = controller_.try_send_kb_general_data(static_cast<KeyboardCtrlKey>(state & 0xFF), keys);
+        if (!sent) return false;
+        const bool ok = *sent;
+
+        reports_.fetch_add(1, std::memory_order_relaxed);
+        if (ok) {
+            sent_keyboard_ = state;
+        } else {
+            failures_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    bool TickedInput::tick_mouse() {
+        const uint8_t buttons = buttons_.load(std::memory_order_acquire);
+
+        // A pending absolute position wins the mouse slot; relative motion waits for the next one
+        if (const auto cursor = absolute_.take()) {
+            const uint8_t held = buttons | cursor->buttons;
+            const bool ok = controller_.send_ms_abs_data(static_cast<MouseButton>(held),
+                                                         cursor->x, cursor->y, cursor->wheel);
+            reports_.fetch_add(1, std::memory_order_relaxed);
+            if (ok) {
+                sent_buttons_ = held;
+            } else {
+                // Retry the position next tick unless the producer has already posted a newer one
+                absolute_.restore(*cursor);
+                failures_.fetch_add(1, std::memory_order_relaxed);
+            }
+            return true;
+        }
+
+        const int8_t x = take_clamped(x_delta_);
+        const int8_t y = take_clamped(y_delta_);
+        const int8_t wheel = take_clamped(wheel_delta_);
+        if (buttons == sent_buttons_ && x == 0 && y == 0 && wheel == 0) return false;
+
+        const bool ok = controller_.send_ms_rel_data(static_cast<MouseButton>(buttons), x, y, wheel);
+
+        reports_.fetch_add(1, std::memory_order_relaxed);
+        if (ok) {
+            sent_buttons_ = buttons;
+        } else {
+            // Put the motion back so the next tick carries it instead of losing it
+            x_delta_.fetch_add(x, std::memory_order_acq_rel);
+            y_delta_.fetch_add(y, std::memory_order_acq_rel);
+            wheel_delta_.fetch_add(wheel, std::memory_order_acq_rel);
+            failures_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+}